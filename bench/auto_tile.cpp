@@ -0,0 +1,176 @@
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/templates/vector.hpp>
+#include <array>
+#include <random>
+#include <vector>
+
+#include "auto_tiled_node/auto_tiled_node.h"
+#include "bench.h"
+#include "core/cell_id.h"
+#include "int_node/int_node.h"
+
+using Rule = HexMapAutoTiledNode::Rule;
+using RuleMatch = HexMapAutoTiledNode::RuleMatch;
+using CellMap = HexMapIntNode::CellMap;
+
+static const int CELL_TYPES = 4;
+
+// Build a square map of `count` cells in a single layer, with a hill of a
+// second layer in the middle.  Cell types are random, but clumped together
+// so that neighbor patterns repeat like they would in a real map.
+static CellMap build_map(int count) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> type(1, CELL_TYPES);
+    int side = 1;
+    while (side * side < count) {
+        side++;
+    }
+
+    CellMap cells;
+    cells.reserve(count);
+    int value = type(rng);
+    for (int i = 0; i < count; i++) {
+        int q = i % side, r = i / side;
+        if (rng() % 8 == 0) {
+            value = type(rng);
+        }
+        cells.insert(HexMapCellId(q - r / 2, r, 0), value);
+        if (abs(q - side / 2) < side / 8 && abs(r - side / 2) < side / 8) {
+            cells.insert(HexMapCellId(q - r / 2, r, 1), value);
+        }
+    }
+    return cells;
+}
+
+// Build `count` rules of increasing complexity: the center cell type, then a
+// mix of neighbor types, empty cells above, and not-type constraints.
+static void build_rules(int count,
+        HashMap<uint16_t, Rule> &rules,
+        Vector<int> &rules_order) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> type(1, CELL_TYPES);
+    std::uniform_int_distribution<int> direction(0, 5);
+
+    rules.clear();
+    rules_order.clear();
+    for (int i = 0; i < count; i++) {
+        Rule rule;
+        rule.set_cell_type(HexMapCellId(0, 0, 0), (i % CELL_TYPES) + 1);
+        rule.set_cell_empty(HexMapCellId(0, 0, 1));
+        for (int n = 0; n < i % 4; n++) {
+            HexMapCellId offset = HexMapCellId::DIRECTIONS[direction(rng)];
+            rule.set_cell_type(offset, type(rng), n % 2 == 1);
+        }
+        rules.insert(i, rule);
+        rules_order.push_back(i);
+    }
+}
+
+BENCH_CASE("auto_tile") {
+    // Rule::match() against the neighborhoods of real map cells
+    {
+        CellMap cells = build_map(10000);
+        HashMap<uint16_t, Rule> rules;
+        Vector<int> rules_order;
+        build_rules(16, rules, rules_order);
+
+        std::vector<std::array<int32_t, Rule::PATTERN_CELLS>> patterns;
+        for (const auto &iter : cells) {
+            HexMapCellId cell_id = iter.key;
+            std::array<int32_t, Rule::PATTERN_CELLS> values;
+            for (unsigned i = 0; i < Rule::PATTERN_CELLS; i++) {
+                HexMapCellId id = cell_id + Rule::CellOffsets[i];
+                const uint16_t *ptr = cells.getptr(id);
+                values[i] = ptr ? *ptr : -1;
+            }
+            patterns.push_back(values);
+        }
+
+        // Gather the pattern values for every cell, the lookups done by
+        // match_rules(), from the cell map and from an equivalent HashMap.
+        HashMap<HexMapCellId::Key, uint16_t> hash_map;
+        for (const auto &iter : cells) {
+            hash_map.insert(iter.key, iter.value);
+        }
+        auto gather = [&](const auto &map) {
+            int32_t sum = 0;
+            for (const auto &iter : cells) {
+                HexMapCellId cell_id = iter.key;
+                for (unsigned i = 0; i < Rule::PATTERN_CELLS; i++) {
+                    const uint16_t *ptr =
+                            map.getptr(cell_id + Rule::CellOffsets[i]);
+                    sum += ptr ? *ptr : -1;
+                }
+            }
+            bench_keep(sum);
+        };
+        bench.run("pattern_lookup/hash_map",
+                cells.size() * Rule::PATTERN_CELLS,
+                [&] { gather(hash_map); });
+        bench.run("pattern_lookup/cell_map",
+                cells.size() * Rule::PATTERN_CELLS,
+                [&] { gather(cells); });
+
+        bench.run("rule_match",
+                patterns.size() * rules.size(),
+                [&] {
+                    int matched = 0;
+                    HexMapTileOrientation orientation;
+                    for (const auto &values : patterns) {
+                        for (const auto &iter : rules) {
+                            matched += iter.value.match(
+                                    values.data(), orientation);
+                        }
+                    }
+                    bench_keep(matched);
+                });
+    }
+
+    // full rule application, without the TiledNode update
+    for (int count : { 10000, 100000, 1000000 }) {
+        for (int rule_count : { 1, 16, 64 }) {
+            std::string name = "match_rules/" + std::to_string(count) +
+                    "_cells/" + std::to_string(rule_count) + "_rules";
+            if (!bench.enabled(name)) {
+                continue;
+            }
+
+            CellMap cells = build_map(count);
+            HashMap<uint16_t, Rule> rules;
+            Vector<int> rules_order;
+            build_rules(rule_count, rules, rules_order);
+            LocalVector<RuleMatch> matches;
+
+            bench.run(name, cells.size(), [&] {
+                HexMapAutoTiledNode::match_rules(
+                        cells, rules, rules_order, matches);
+                bench_keep(matches.size());
+            });
+        }
+    }
+}
+
+BENCH_CASE("serialize") {
+    for (int count : { 10000, 100000, 1000000 }) {
+        std::string suffix = "/" + std::to_string(count) + "_cells";
+        if (!bench.enabled("encode" + suffix) &&
+                !bench.enabled("decode" + suffix)) {
+            continue;
+        }
+
+        CellMap cells = build_map(count);
+        std::vector<uint8_t> buf(
+                cells.size() * HexMapIntNode::ENCODED_CELL_SIZE);
+
+        bench.run("encode" + suffix, cells.size(), [&] {
+            HexMapIntNode::encode_cells(cells, buf.data());
+            bench_keep(buf[0]);
+        });
+        bench.run("decode" + suffix, cells.size(), [&] {
+            CellMap decoded;
+            HexMapIntNode::decode_cells(buf.data(), buf.size(), decoded);
+            bench_keep(decoded.size());
+        });
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal benchmark harness for the headless `bench/bench` binary.
+//
+// Benchmark cases are registered with BENCH_CASE(), and report timings with
+// Bench::run():
+//
+//      BENCH_CASE("cell_id") {
+//          bench.run("from_unit_point", points.size(), [&] {
+//              for (const Vector3 &point : points) {
+//                  bench_keep(HexMapCellId::from_unit_point(point));
+//              }
+//          });
+//      }
+//
+// Each Bench::run() call produces one result row; see main.cpp for the
+// output formats.
+
+class Bench {
+public:
+    struct Result {
+        std::string name;
+        /// iterations of the function per sample
+        uint64_t iterations;
+        /// number of samples taken
+        unsigned samples;
+        /// items processed per iteration; used to calculate ns_per_item
+        uint64_t items;
+        /// nanoseconds per iteration; median & fastest sample
+        double ns_median;
+        double ns_min;
+    };
+
+    /// minimum time each sample should run for
+    double min_sample_ms = 50;
+    /// number of samples to take for each benchmark
+    unsigned samples = 5;
+    /// only run benchmarks whose name contains this string
+    std::string filter;
+
+    std::vector<Result> results;
+
+    /// time `func` and add a result row named `<case>/<name>`
+    /// @param [items] number of items `func` processes per call
+    void run(const std::string &name,
+            uint64_t items,
+            const std::function<void()> &func);
+
+    /// check if a benchmark name matches the filter; used to skip expensive
+    /// setup for benchmarks that will not be run
+    bool enabled(const std::string &name) const;
+
+    /// name of the case being run; set by the harness
+    std::string case_name;
+};
+
+using BenchCaseFunc = void (*)(Bench &);
+
+/// register a benchmark case; use BENCH_CASE() instead
+int bench_register(const char *name, BenchCaseFunc func);
+
+/// prevent the compiler from optimizing away a computed value
+template <typename T>
+inline void bench_keep(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const T *volatile sink;
+    sink = &value;
+#endif
+}
+
+#define BENCH_CONCAT_INNER(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_INNER(a, b)
+#define BENCH_CASE_IMPL(name, func)                                           \
+    static void func(Bench &bench);                                           \
+    static int BENCH_CONCAT(func, _registered) = bench_register(name, func);  \
+    static void func(Bench &bench)
+#define BENCH_CASE(name)                                                      \
+    BENCH_CASE_IMPL(name, BENCH_CONCAT(bench_case_, __LINE__))
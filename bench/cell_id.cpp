@@ -0,0 +1,325 @@
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/hashfuncs.hpp>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "core/cell_id.h"
+#include "core/cell_map.h"
+#include "core/iter_axial.h"
+#include "core/iter_cube.h"
+#include "core/iter_radial.h"
+#include "core/iter_spiral.h"
+#include "core/space.h"
+
+using Key = HexMapCellId::Key;
+
+// random cell keys spread over a layered region, similar to a map
+static std::vector<Key> random_keys(size_t count, int range) {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> coord(-range, range);
+    std::uniform_int_distribution<int> layer(-4, 4);
+    std::vector<Key> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        keys.push_back(Key(HexMapCellId(coord(rng), coord(rng), layer(rng))));
+    }
+    return keys;
+}
+
+BENCH_CASE("cell_id") {
+    const std::vector<Key> keys = random_keys(100000, 300);
+
+    bench.run("key_hash", keys.size(), [&] {
+        uint32_t sum = 0;
+        for (const Key &key : keys) {
+            sum += HashMapHasherDefault::hash((uint64_t)key);
+        }
+        bench_keep(sum);
+    });
+
+    bench.run("hash_map_insert", keys.size(), [&] {
+        HashMap<Key, uint16_t> map;
+        for (const Key &key : keys) {
+            map.insert(key, 1);
+        }
+        bench_keep(map.size());
+    });
+
+    HashMap<Key, uint16_t> map;
+    for (const Key &key : keys) {
+        map.insert(key, 1);
+    }
+    bench.run("hash_map_lookup", keys.size(), [&] {
+        int found = 0;
+        for (const Key &key : keys) {
+            found += map.has(key);
+        }
+        bench_keep(found);
+    });
+
+    bench.run("cell_map_insert", keys.size(), [&] {
+        HexMapCellMap<uint16_t> map;
+        for (const Key &key : keys) {
+            map.insert(key, 1);
+        }
+        bench_keep(map.size());
+    });
+
+    HexMapCellMap<uint16_t> cell_map;
+    for (const Key &key : keys) {
+        cell_map.insert(key, 1);
+    }
+    bench.run("cell_map_lookup", keys.size(), [&] {
+        int found = 0;
+        for (const Key &key : keys) {
+            found += cell_map.has(key);
+        }
+        bench_keep(found);
+    });
+
+    // lookups that mostly miss, like probing neighbors of sparse cells
+    const std::vector<Key> miss_keys = random_keys(100000, 3000);
+    bench.run("hash_map_lookup_miss", miss_keys.size(), [&] {
+        int found = 0;
+        for (const Key &key : miss_keys) {
+            found += map.has(key);
+        }
+        bench_keep(found);
+    });
+    bench.run("cell_map_lookup_miss", miss_keys.size(), [&] {
+        int found = 0;
+        for (const Key &key : miss_keys) {
+            found += cell_map.has(key);
+        }
+        bench_keep(found);
+    });
+
+    std::mt19937 rng(5678);
+    std::uniform_real_distribution<float> coord(-500.0, 500.0);
+    std::vector<Vector3> points;
+    for (int i = 0; i < 100000; i++) {
+        points.push_back(Vector3(coord(rng), coord(rng) / 50, coord(rng)));
+    }
+    bench.run("from_unit_point", points.size(), [&] {
+        for (const Vector3 &point : points) {
+            bench_keep(HexMapCellId::from_unit_point(point));
+        }
+    });
+
+    bench.run("unit_center", keys.size(), [&] {
+        for (const Key &key : keys) {
+            bench_keep(HexMapCellId(key).unit_center());
+        }
+    });
+
+    // point to cell conversion, one at a time vs. the batch call
+    HexMapSpace space;
+    space.set_cell_scale(Vector3(1.5, 0.75, 1.5));
+    std::vector<Key> out(points.size());
+    bench.run("space/get_cell_id", points.size(), [&] {
+        for (size_t i = 0; i < points.size(); i++) {
+            out[i] = space.get_cell_id(points[i]);
+        }
+        bench_keep(out[0]);
+    });
+    bench.run("space/get_cell_ids", points.size(), [&] {
+        space.get_cell_ids(points.data(), points.size(), out.data());
+        bench_keep(out[0]);
+    });
+
+    std::vector<Vector3> centers(keys.size());
+    bench.run("space/get_cell_centers", keys.size(), [&] {
+        space.get_cell_centers(keys.data(), keys.size(), centers.data());
+        bench_keep(centers[0]);
+    });
+}
+
+// editor selection boxes, on the floor and on a wall
+BENCH_CASE("select") {
+    HexMapSpace space;
+    space.set_cell_scale(Vector3(1.5, 0.75, 1.5));
+
+    for (real_t size : { 10.0, 50.0, 200.0 }) {
+        std::string suffix = "/" + std::to_string((int)size);
+        const Vector3 floor[4] = {
+            Vector3(-size, 0.1, -size),
+            Vector3(size, 0.1, -size),
+            Vector3(size, 0.1, size),
+            Vector3(-size, 0.1, size),
+        };
+        const Vector3 wall[4] = {
+            Vector3(-size, -size, 0.2),
+            Vector3(size, -size, 0.2),
+            Vector3(size, size, 0.2),
+            Vector3(-size, size, 0.2),
+        };
+
+        for (const Vector3 *quad : { floor, wall }) {
+            auto select = [&] {
+                return space.get_cell_ids_in_local_quad(
+                        quad[0], quad[1], quad[2], quad[3]);
+            };
+            std::string name = (quad == floor ? "floor" : "wall") + suffix;
+            bench.run(name, select().size(), [&] {
+                bench_keep(select().size());
+            });
+        }
+    }
+}
+
+// every cell in a dense block of layered map, like a filled in region
+static std::vector<Key> block_keys(int side, int layers) {
+    std::vector<Key> keys;
+    for (int y = 0; y < layers; y++) {
+        for (int r = 0; r < side; r++) {
+            for (int q = 0; q < side; q++) {
+                keys.push_back(Key(HexMapCellId(q - r / 2, r, y)));
+            }
+        }
+    }
+    return keys;
+}
+
+// Look up the six planar neighbors of every cell in a sorted key array.
+// Compares how well each ordering keeps neighbors in nearby memory.
+template <typename Code>
+static int sorted_neighbor_scan(const std::vector<uint64_t> &sorted,
+        const std::vector<Key> &keys,
+        Code code) {
+    int found = 0;
+    for (const Key &key : keys) {
+        HexMapCellId cell_id(key);
+        for (int i = 0; i < 6; i++) {
+            uint64_t value =
+                    code(Key(cell_id + HexMapCellId::DIRECTIONS[i]));
+            found += std::binary_search(sorted.begin(), sorted.end(), value);
+        }
+    }
+    return found;
+}
+
+BENCH_CASE("morton") {
+    const std::vector<Key> keys = random_keys(100000, 300);
+
+    bench.run("encode", keys.size(), [&] {
+        uint64_t sum = 0;
+        for (const Key &key : keys) {
+            sum += key.to_morton();
+        }
+        bench_keep(sum);
+    });
+
+    std::vector<uint64_t> codes;
+    for (const Key &key : keys) {
+        codes.push_back(key.to_morton());
+    }
+    bench.run("decode", codes.size(), [&] {
+        uint64_t sum = 0;
+        for (uint64_t code : codes) {
+            sum += Key::from_morton(code).key;
+        }
+        bench_keep(sum);
+    });
+
+    // sorting cells by the plain key vs. the morton code
+    bench.run("sort/key", keys.size(), [&] {
+        std::vector<uint64_t> sorted(keys.begin(), keys.end());
+        std::sort(sorted.begin(), sorted.end());
+        bench_keep(sorted[0]);
+    });
+    bench.run("sort/morton", keys.size(), [&] {
+        std::vector<uint64_t> sorted;
+        sorted.reserve(keys.size());
+        for (const Key &key : keys) {
+            sorted.push_back(key.to_morton());
+        }
+        std::sort(sorted.begin(), sorted.end());
+        bench_keep(sorted[0]);
+    });
+
+    // neighborhood scans over a 512x512x4 block stored in sorted arrays,
+    // visiting the cells in the storage order
+    const std::vector<Key> block = block_keys(512, 4);
+    auto key_code = [](Key key) -> uint64_t { return key.key; };
+    auto morton_code = [](Key key) { return key.to_morton(); };
+    for (int use_morton = 0; use_morton < 2; use_morton++) {
+        std::vector<uint64_t> sorted;
+        for (const Key &key : block) {
+            sorted.push_back(use_morton ? key.to_morton() : key.key);
+        }
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<Key> order;
+        for (uint64_t code : sorted) {
+            order.push_back(use_morton ? Key::from_morton(code) : Key(code));
+        }
+
+        bench.run(use_morton ? "neighbor_scan/morton" : "neighbor_scan/key",
+                order.size() * 6,
+                [&] {
+                    bench_keep(use_morton
+                                    ? sorted_neighbor_scan(
+                                              sorted, order, morton_code)
+                                    : sorted_neighbor_scan(
+                                              sorted, order, key_code));
+                });
+    }
+}
+
+// sum the cell coordinates so the loop cannot be optimized away
+template <typename Iter>
+static void walk(Iter iter) {
+    int sum = 0;
+    for (const HexMapCellId &cell : iter) {
+        sum += cell.q + cell.r + cell.y;
+    }
+    bench_keep(sum);
+}
+
+BENCH_CASE("iter") {
+    const HexMapCellId center(12, -4, 3);
+
+    for (unsigned radius : { 1, 5, 20 }) {
+        std::string suffix = "/r" + std::to_string(radius);
+        unsigned planar_cells = 3 * radius * (radius + 1) + 1;
+        unsigned volume_cells = planar_cells * (2 * radius + 1);
+
+        bench.run("axial_all" + suffix, volume_cells, [&] {
+            walk(HexMapIterAxial(center, radius));
+        });
+        bench.run("radial_all" + suffix, volume_cells, [&] {
+            walk(HexMapIterRadial(center, radius));
+        });
+        bench.run("radial_qrs" + suffix, planar_cells, [&] {
+            walk(HexMapIterRadial(center, radius, false, HexMapPlanes::QRS));
+        });
+        // planar neighbors the way HexMapIterRadial found them before
+        // HexMapIterSpiral; filter the axial bounding box by distance
+        bench.run("axial_qrs_filtered" + suffix, planar_cells, [&] {
+            int sum = 0;
+            for (const HexMapCellId &cell :
+                    HexMapIterAxial(center, radius, HexMapPlanes::QRS)) {
+                if (center.distance(cell) <= radius) {
+                    sum += cell.q + cell.r + cell.y;
+                }
+            }
+            bench_keep(sum);
+        });
+        bench.run("spiral" + suffix, planar_cells, [&] {
+            walk(HexMapIterSpiral(center, radius));
+        });
+    }
+
+    for (float size : { 4.0f, 32.0f }) {
+        std::string suffix = "/" + std::to_string((int)size);
+        HexMapIterCube cube(
+                Vector3(-size, -2, -size), Vector3(size, 2, size));
+        uint64_t cells = 0;
+        for (const HexMapCellId &cell : cube) {
+            (void)cell;
+            cells++;
+        }
+        bench.run("cube" + suffix, cells, [&] { walk(cube); });
+    }
+}
@@ -0,0 +1,204 @@
+// Headless benchmarks for the HexMap core data structures & algorithms.
+//
+// Build with `scons bench target=template_release`, then run:
+//
+//      bench/bench [--format=json|csv] [--output=path] [--filter=substring]
+//                  [--samples=N] [--min-sample-ms=N]
+//
+// Results are written to stdout by default.  Each row has the benchmark
+// name, the iterations per sample, the number of samples, the items
+// processed per iteration, and the median & fastest time per iteration and
+// per item in nanoseconds.
+//
+// Nothing here requires the engine or a GPU.  The godot-cpp containers
+// allocate through the engine, so main() points the godot-cpp allocator at
+// malloc() before running the benchmarks.  Only code that does not touch
+// Variant types, Objects, or engine singletons can be benchmarked.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <godot_cpp/godot.hpp>
+
+#include "bench.h"
+
+struct BenchCase {
+    const char *name;
+    BenchCaseFunc func;
+};
+
+static std::vector<BenchCase> &get_cases() {
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+int bench_register(const char *name, BenchCaseFunc func) {
+    get_cases().push_back(BenchCase{ .name = name, .func = func });
+    return 0;
+}
+
+bool Bench::enabled(const std::string &name) const {
+    return filter.empty() ||
+            (case_name + "/" + name).find(filter) != std::string::npos;
+}
+
+static double time_ns(const std::function<void()> &func, uint64_t loops) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < loops; i++) {
+        func();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+void Bench::run(const std::string &name,
+        uint64_t items,
+        const std::function<void()> &func) {
+    if (!enabled(name)) {
+        return;
+    }
+
+    // warm up, and find the iterations needed to fill a sample
+    uint64_t iterations = 1;
+    double min_sample_ns = min_sample_ms * 1e6;
+    for (;;) {
+        double ns = time_ns(func, iterations);
+        if (ns >= min_sample_ns || iterations >= (1ull << 40)) {
+            break;
+        }
+        double scale = ns > 0 ? min_sample_ns / ns : 10;
+        iterations *= (uint64_t)std::clamp(scale * 1.2, 2.0, 10.0);
+    }
+
+    std::vector<double> sample_ns;
+    for (unsigned i = 0; i < samples; i++) {
+        sample_ns.push_back(time_ns(func, iterations) / iterations);
+    }
+    std::sort(sample_ns.begin(), sample_ns.end());
+
+    results.push_back(Result{
+            .name = case_name + "/" + name,
+            .iterations = iterations,
+            .samples = samples,
+            .items = items,
+            .ns_median = sample_ns[sample_ns.size() / 2],
+            .ns_min = sample_ns[0],
+    });
+    const Result &result = results.back();
+    fprintf(stderr,
+            "%-50s %14.1f ns/iter %10.2f ns/item\n",
+            result.name.c_str(),
+            result.ns_median,
+            result.ns_median / std::max<uint64_t>(items, 1));
+}
+
+static void write_json(FILE *out, const std::vector<Bench::Result> &results) {
+    fputs("{\n  \"benchmarks\": [\n", out);
+    for (size_t i = 0; i < results.size(); i++) {
+        const Bench::Result &r = results[i];
+        uint64_t items = std::max<uint64_t>(r.items, 1);
+        fprintf(out,
+                "    {\"name\": \"%s\", \"iterations\": %llu, "
+                "\"samples\": %u, \"items\": %llu, "
+                "\"ns_per_iter\": %.3f, \"ns_per_iter_min\": %.3f, "
+                "\"ns_per_item\": %.3f}%s\n",
+                r.name.c_str(),
+                (unsigned long long)r.iterations,
+                r.samples,
+                (unsigned long long)r.items,
+                r.ns_median,
+                r.ns_min,
+                r.ns_median / items,
+                i + 1 < results.size() ? "," : "");
+    }
+    fputs("  ]\n}\n", out);
+}
+
+static void write_csv(FILE *out, const std::vector<Bench::Result> &results) {
+    fputs("name,iterations,samples,items,ns_per_iter,ns_per_iter_min,"
+          "ns_per_item\n",
+            out);
+    for (const Bench::Result &r : results) {
+        uint64_t items = std::max<uint64_t>(r.items, 1);
+        fprintf(out,
+                "%s,%llu,%u,%llu,%.3f,%.3f,%.3f\n",
+                r.name.c_str(),
+                (unsigned long long)r.iterations,
+                r.samples,
+                (unsigned long long)r.items,
+                r.ns_median,
+                r.ns_min,
+                r.ns_median / items);
+    }
+}
+
+// godot-cpp allocator hooks; normally provided by the engine
+static void *bench_mem_alloc(size_t bytes) { return malloc(bytes); }
+static void *bench_mem_realloc(void *ptr, size_t bytes) {
+    return realloc(ptr, bytes);
+}
+static void bench_mem_free(void *ptr) { free(ptr); }
+
+static const char *get_arg(const char *arg, const char *name) {
+    size_t len = strlen(name);
+    if (strncmp(arg, name, len) == 0 && arg[len] == '=') {
+        return arg + len + 1;
+    }
+    return nullptr;
+}
+
+int main(int argc, char **argv) {
+    godot::internal::gdextension_interface_mem_alloc = bench_mem_alloc;
+    godot::internal::gdextension_interface_mem_realloc = bench_mem_realloc;
+    godot::internal::gdextension_interface_mem_free = bench_mem_free;
+
+    Bench bench;
+    const char *format = "json";
+    const char *output = nullptr;
+    for (int i = 1; i < argc; i++) {
+        const char *value;
+        if ((value = get_arg(argv[i], "--format"))) {
+            format = value;
+        } else if ((value = get_arg(argv[i], "--output"))) {
+            output = value;
+        } else if ((value = get_arg(argv[i], "--filter"))) {
+            bench.filter = value;
+        } else if ((value = get_arg(argv[i], "--samples"))) {
+            bench.samples = std::max(atoi(value), 1);
+        } else if ((value = get_arg(argv[i], "--min-sample-ms"))) {
+            bench.min_sample_ms = atof(value);
+        } else {
+            fprintf(stderr, "unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (strcmp(format, "json") != 0 && strcmp(format, "csv") != 0) {
+        fprintf(stderr, "unknown format: %s\n", format);
+        return 1;
+    }
+
+    for (const BenchCase &c : get_cases()) {
+        bench.case_name = c.name;
+        c.func(bench);
+    }
+
+    FILE *out = stdout;
+    if (output != nullptr) {
+        out = fopen(output, "w");
+        if (out == nullptr) {
+            fprintf(stderr, "failed to open %s\n", output);
+            return 1;
+        }
+    }
+    if (strcmp(format, "csv") == 0) {
+        write_csv(out, bench.results);
+    } else {
+        write_json(out, bench.results);
+    }
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
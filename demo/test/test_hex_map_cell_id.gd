@@ -76,6 +76,27 @@ var get_neighbors_params = ParameterFactory.named_parameters(
 func test_get_neighbors(params=use_parameters(get_neighbors_params)):
     assert_cells_eq(params.center.get_neighbors(), params.neighbors)
 
+func test_get_neighbor_vecs(params=use_parameters(get_neighbors_params)):
+    var found := []
+    for vec in params.center.get_neighbor_vecs():
+        found.push_back(HexMapCellId.from_vec(vec))
+    assert_cells_eq(found, params.neighbors)
+
+func test_ring_and_spiral_vecs() -> void:
+    var center := HexMapCellId.at(2, -1, 3)
+    assert_eq(center.get_ring_vecs(0).size(), 1)
+    assert_eq(center.get_ring_vecs(1).size(), 6)
+    assert_eq(center.get_ring_vecs(3).size(), 18)
+    for vec in center.get_ring_vecs(3):
+        assert_eq(int(vec.y), 3)
+
+    var spiral := center.get_spiral_vecs(2)
+    assert_eq(spiral.size(), 19)
+    assert_eq(spiral[0], Vector3(center.as_vec()))
+
+    var keys := HexMapCellId.vecs_to_keys(spiral)
+    assert_eq(keys[0], center.as_int())
+
 func test_rotate() -> void:
     assert_cell_eq(HexMapCellId.at(0,0,0).rotate(0), HexMapCellId.at(0,0,0))
     assert_cell_eq(HexMapCellId.at(0,0,0).rotate(1), HexMapCellId.at(0,0,0))
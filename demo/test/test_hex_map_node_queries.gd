@@ -0,0 +1,94 @@
+extends HexMapTest
+
+const FLOOR := 1
+const WALL := 2
+
+# a row of floor cells along the q axis, with a wall at q = 3, y = 1
+func build_map() -> HexMapInt:
+    var node: HexMapInt = autofree(HexMapInt.new())
+    for q in range(-6, 7):
+        node.set_cell(HexMapCellId.at(q, 0, 0), FLOOR)
+    node.set_cell(HexMapCellId.at(3, 0, 1), WALL)
+    return node
+
+func test_raycast_cells():
+    var node := build_map()
+    var origin := node.get_cell_center(HexMapCellId.at(0, 0, 1))
+    var target := node.get_cell_center(HexMapCellId.at(6, 0, 1))
+    var hits := node.raycast_cells(origin, target)
+    assert_eq(hits.size(), 1)
+    assert_eq(hits[0]["cell_id"], Vector3i(3, 1, 0))
+    assert_eq(hits[0]["value"], WALL)
+    assert_eq(hits[0]["normal"], Vector3(-1, 0, 0))
+
+    # straight down hits the floor below
+    hits = node.raycast_cells(origin, origin + Vector3(0, -5, 0))
+    assert_eq(hits[0]["cell_id"], Vector3i(0, 0, 0))
+    assert_eq(hits[0]["normal"], Vector3(0, 1, 0))
+
+func test_line_of_sight():
+    var node := build_map()
+    assert_true(node.has_line_of_sight(Vector3i(0, 1, 0), Vector3i(2, 1, 0)))
+    assert_false(node.has_line_of_sight(Vector3i(0, 1, 0), Vector3i(5, 1, 0)))
+    assert_true(node.has_line_of_sight(Vector3i(0, 1, 0), Vector3i(5, 1, 0),
+        PackedInt32Array([FLOOR])), "only floor is opaque")
+
+func test_line_of_sight_changing_layer():
+    # a wall beside the origin, and a floor above it; the line to the cell
+    # diagonally up and over must not slip between them
+    var node: HexMapInt = autofree(HexMapInt.new())
+    node.set_cell(HexMapCellId.at(1, 0, 0), WALL)
+    node.set_cell(HexMapCellId.at(0, 0, 1), FLOOR)
+    var opaque := PackedInt32Array([WALL, FLOOR])
+    assert_false(node.has_line_of_sight(Vector3i(0, 0, 0), Vector3i(1, 1, 0),
+        opaque))
+    assert_false(node.has_line_of_sight(Vector3i(1, 1, 0), Vector3i(0, 0, 0),
+        opaque))
+
+func test_fov():
+    var node := build_map()
+    var opaque := PackedInt32Array([WALL])
+    var visible := node.compute_fov(Vector3i(0, 1, 0), 5, opaque)
+    assert_true(visible.has(Vector3(3, 1, 0)), "wall is visible")
+    assert_false(visible.has(Vector3(4, 1, 0)), "cell behind wall is hidden")
+    assert_true(visible.has(Vector3(-4, 1, 0)))
+
+    var batch := node.compute_fov_batch(
+        PackedVector3Array([Vector3(0, 1, 0), Vector3(5, 1, 0)]), 5, opaque)
+    assert_eq(batch.size(), 2)
+    assert_eq(batch[0], visible)
+
+func test_memory_usage():
+    var empty: HexMapInt = autofree(HexMapInt.new())
+    assert_eq(empty.get_memory_usage()["cell_map"], 0)
+
+    var usage := build_map().get_memory_usage()
+    assert_gt(usage["cell_map"], 0)
+    assert_eq(usage["total"], usage["cell_map"] + usage["cell_types"])
+
+func test_snapshot():
+    var node := build_map()
+    var snapshot := node.get_snapshot()
+    assert_eq(snapshot.get_cell_count(), 14)
+    assert_eq(snapshot.get_cell_value(Vector3i(3, 1, 0)), WALL)
+    assert_eq(snapshot.get_cell(Vector3i(0, 0, 0))["value"], FLOOR)
+    assert_false(snapshot.has(Vector3i(0, 1, 0)))
+    assert_eq(snapshot.get_occupied_neighbor_vecs(Vector3i(0, 0, 0)).size(), 2)
+    assert_same(node.get_snapshot(), snapshot, "reused until a cell changes")
+
+    # edits made after the snapshot was taken are not visible in it
+    node.set_cell(HexMapCellId.at(0, 0, 1), WALL)
+    assert_false(snapshot.has(Vector3i(0, 1, 0)))
+    assert_ne(node.get_snapshot(), snapshot)
+    assert_true(node.get_snapshot().has(Vector3i(0, 1, 0)))
+
+    # read from worker threads
+    var found := [0]
+    var mutex := Mutex.new()
+    var task := WorkerThreadPool.add_group_task(func(i: int):
+        var value := snapshot.get_cell_value(Vector3i(i - 6, 0, 0))
+        mutex.lock()
+        found[0] += int(value == FLOOR)
+        mutex.unlock(), 13)
+    WorkerThreadPool.wait_for_group_task_completion(task)
+    assert_eq(found[0], 13)
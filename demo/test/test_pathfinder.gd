@@ -0,0 +1,92 @@
+extends HexMapTest
+
+const GROUND := 1
+const WATER := 2
+const WALL := 3
+
+# build a 7 cell wide strip of ground along the q axis
+func build_strip() -> HexMapInt:
+    var node: HexMapInt = autofree(HexMapInt.new())
+    for q in range(7):
+        node.set_cell(HexMapCellId.at(q, 0, 0), GROUND)
+        node.set_cell(HexMapCellId.at(q, 1, 0), GROUND)
+    return node
+
+func build_pathfinder(node: HexMapNode) -> HexMapPathfinder:
+    var pathfinder := HexMapPathfinder.new()
+    pathfinder.map = node
+    pathfinder.walkable_values = PackedInt32Array([GROUND, WATER])
+    return pathfinder
+
+func test_straight_path():
+    var pathfinder := build_pathfinder(build_strip())
+    var path := pathfinder.find_path(Vector3i(0, 0, 0), Vector3i(6, 0, 0))
+    assert_eq(path.size(), 7)
+    assert_eq(path[0], Vector3(0, 0, 0))
+    assert_eq(path[6], Vector3(6, 0, 0))
+
+func test_unreachable():
+    var pathfinder := build_pathfinder(build_strip())
+    var path := pathfinder.find_path(Vector3i(0, 0, 0), Vector3i(20, 0, 0))
+    assert_eq(path.size(), 0)
+
+func test_value_cost():
+    var node := build_strip()
+    node.set_cell(HexMapCellId.at(3, 0, 0), WATER)
+    var pathfinder := build_pathfinder(node)
+    pathfinder.set_value_cost(WATER, 10.0)
+    var path := pathfinder.find_path(Vector3i(0, 0, 0), Vector3i(6, 0, 0))
+    assert_false(path.has(Vector3(3, 0, 0)), "path avoids expensive cell")
+
+func test_cells_changed_invalidates():
+    var node := build_strip()
+    var pathfinder := build_pathfinder(node)
+    assert_eq(pathfinder.find_path(Vector3i(0, 0, 0), Vector3i(6, 0, 0))
+        .size(), 7)
+
+    # put a wall on top of the row so it can no longer be stood on
+    for r in range(2):
+        node.set_cell(HexMapCellId.at(3, r, 1), WALL)
+    assert_eq(pathfinder.find_path(Vector3i(0, 0, 0), Vector3i(6, 0, 0))
+        .size(), 0)
+
+func test_step_limits():
+    var node := build_strip()
+    for r in range(2):
+        node.set_cell(HexMapCellId.at(3, r, 0), HexMapNode.CELL_VALUE_NONE)
+        node.set_cell(HexMapCellId.at(3, r, -2), GROUND)
+    var pathfinder := build_pathfinder(node)
+    pathfinder.max_step_down = 1
+    assert_eq(pathfinder.find_path(Vector3i(0, 0, 0), Vector3i(6, 0, 0))
+        .size(), 0)
+
+    pathfinder.max_step_down = 2
+    pathfinder.max_step_up = 2
+    assert_eq(pathfinder.find_path(Vector3i(0, 0, 0), Vector3i(6, 0, 0))
+        .size(), 7)
+
+func test_flow_field():
+    var pathfinder := build_pathfinder(build_strip())
+    var field := pathfinder.build_flow_field(
+        PackedVector3Array([Vector3(0, 0, 0), Vector3(6, 0, 0)]))
+    field.wait()
+    assert_eq(field.get_distance(Vector3i(0, 0, 0)), 0.0)
+    assert_eq(field.get_distance(Vector3i(2, 0, 0)), 2.0)
+    assert_eq(field.get_distance(Vector3i(5, 0, 0)), 1.0)
+    assert_eq(field.get_next_cell(Vector3i(5, 0, 0)), Vector3i(6, 0, 0))
+    assert_eq(field.get_next_cell(Vector3i(6, 0, 0)), Vector3i(6, 0, 0))
+    assert_eq(field.get_distance(Vector3i(20, 0, 0)), INF)
+
+func test_clear_invalidates():
+    var node: HexMapTiled = autofree(HexMapTiled.new())
+    for q in range(7):
+        node.set_cell(HexMapCellId.at(q, 0, 0), GROUND)
+    var pathfinder := build_pathfinder(node)
+    assert_eq(pathfinder.find_path(Vector3i(0, 0, 0), Vector3i(6, 0, 0))
+        .size(), 7)
+
+    # clear() does not emit cells_changed
+    node.clear()
+    assert_false(pathfinder.is_cell_walkable(Vector3i(0, 0, 0)))
+    assert_eq(pathfinder.find_path(Vector3i(0, 0, 0), Vector3i(6, 0, 0))
+        .size(), 0)
@@ -0,0 +1,53 @@
+extends HexMapTest
+
+var node: HexMapTiled
+
+func before_each():
+    node = autofree(HexMapTiled.new())
+    node.cell_custom_data_format = int(HexMapTiled.CUSTOM_DATA_COLOR)
+    for cell in [CellId(0, 0, 0), CellId(1, 0, 0), CellId(20, -5, 2)]:
+        node.set_cell(cell, 1)
+
+func test_default_is_white():
+    assert_eq(node.get_cell_custom_data(CellId(0, 0, 0)), Color.WHITE)
+
+func test_set_cell_custom_data():
+    node.set_cell_custom_data(CellId(1, 0, 0), Color.RED)
+    assert_eq(node.get_cell_custom_data(CellId(1, 0, 0)), Color.RED)
+    assert_eq(node.get_cell_custom_data(CellId(0, 0, 0)), Color.WHITE)
+
+    node.set_cell_custom_data(CellId(1, 0, 0), Color.WHITE)
+    assert_eq(node.get_cell_custom_data(CellId(1, 0, 0)), Color.WHITE)
+
+func test_set_cell_custom_data_empty_cell():
+    node.set_cell_custom_data(CellId(5, 5, 5), Color.RED)
+    assert_eq(node.get_cell_custom_data(CellId(5, 5, 5)), Color.WHITE)
+
+func test_set_cells_custom_data():
+    node.set_cells_custom_data([
+        CellId(0, 0, 0).as_vec(), Color.RED,
+        CellId(20, -5, 2).as_vec(), Color.BLUE,
+        CellId(5, 5, 5).as_vec(), Color.GREEN,
+    ])
+    assert_eq(node.get_cell_custom_data(CellId(0, 0, 0)), Color.RED)
+    assert_eq(node.get_cell_custom_data(CellId(1, 0, 0)), Color.WHITE)
+    assert_eq(node.get_cell_custom_data(CellId(20, -5, 2)), Color.BLUE)
+    assert_eq(node.get_cell_custom_data(CellId(5, 5, 5)), Color.WHITE)
+
+func test_custom_data_survives_octant_rebuild():
+    node.set_cells_custom_data([
+        CellId(0, 0, 0).as_vec(), Color.RED,
+        CellId(20, -5, 2).as_vec(), Color.BLUE,
+    ])
+
+    # changing the octant size recreates all of the octant data
+    node.cell_octant_size = 2
+    assert_eq(node.get_cell_custom_data(CellId(0, 0, 0)), Color.RED)
+    assert_eq(node.get_cell_custom_data(CellId(1, 0, 0)), Color.WHITE)
+    assert_eq(node.get_cell_custom_data(CellId(20, -5, 2)), Color.BLUE)
+
+func test_custom_data_cleared_with_cell():
+    node.set_cell_custom_data(CellId(0, 0, 0), Color.RED)
+    node.set_cell(CellId(0, 0, 0), -1)
+    node.set_cell(CellId(0, 0, 0), 1)
+    assert_eq(node.get_cell_custom_data(CellId(0, 0, 0)), Color.WHITE)
@@ -1,15 +1,16 @@
 #include <godot_cpp/classes/global_constants.hpp>
+#include <godot_cpp/classes/time.hpp>
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/core/error_macros.hpp>
 #include <godot_cpp/core/object.hpp>
 #include <godot_cpp/core/property_info.hpp>
-#include <godot_cpp/templates/hash_set.hpp>
 #include <godot_cpp/variant/callable_method_pointer.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
 #include <godot_cpp/variant/variant.hpp>
 
 #include "auto_tiled_node.h"
 #include "core/iter_radial.h"
+#include "core/memory_usage.h"
 #include "core/tile_orientation.h"
 #include "godot_cpp/variant/string.hpp"
 
@@ -272,11 +273,14 @@ void HexMapAutoTiledNode::on_int_node_cells_changed(Array _cells) {
     }
 }
 
-void HexMapAutoTiledNode::apply_rules() {
-    ERR_FAIL_NULL(int_node);
-    ERR_FAIL_NULL(tiled_node);
+SafeNumeric<uint64_t> HexMapAutoTiledNode::monitor_apply_rules_usec;
+SafeNumeric<int64_t> HexMapAutoTiledNode::monitor_cells_evaluated;
 
-    tiled_node->clear();
+unsigned HexMapAutoTiledNode::match_rules(const HexMapIntNode::CellMap &cells,
+        const HashMap<uint16_t, Rule> &rules,
+        const Vector<int> &rules_order,
+        LocalVector<RuleMatch> &out) {
+    out.clear();
 
     // union the cell masks from all rules to determine which neighboring
     // cells we neet to fetch to match rules
@@ -310,9 +314,10 @@ void HexMapAutoTiledNode::apply_rules() {
     // expand the search space for cell padding needed to support empty
     // tile rules.  This is a small penalty hit when there are no
     // empty-center-cell rules defined.
-    HashSet<HexMapCellId::Key> cell_map;
-    for (const auto &iter : int_node->cell_map) {
-        cell_map.insert(iter.key);
+    HexMapCellSet cell_map;
+    cell_map.reserve(cells.size());
+    for (const auto &iter : cells) {
+        cell_map.insert(iter.key, {});
 
         HexMapCellId cell_id = iter.key;
 
@@ -326,41 +331,31 @@ void HexMapAutoTiledNode::apply_rules() {
 
             for (const HexMapCellId id :
                     cell_id.get_neighbors(radius, HexMapPlanes::QRS, true)) {
-                cell_map.insert(id);
+                cell_map.insert(id, {});
             }
         }
     }
 
-    // To reduce the signals produced from TiledNode::set_cell(), we're going
-    // to build an Array of cells to set to set_cells() after we finish.
-    Array output;
-    Array cell_state;
-    cell_state.resize(HexMapNode::CELL_ARRAY_WIDTH);
-    static_assert(HexMapNode::CELL_ARRAY_INDEX_VEC == 0);
-    static_assert(HexMapNode::CELL_ARRAY_INDEX_VALUE == 1);
-    static_assert(HexMapNode::CELL_ARRAY_INDEX_ORIENTATION == 2);
-
     // Loop through the cells in our search space, attempting to match the
-    // rules in order.  If a rule matches a given cell, we update the tiled
-    // node with the appropriate tile & orientation, then move on to the next
-    // cell.  If no rules match, we don't set anything for that cell in the
-    // tiled node.
-    for (const auto key : cell_map) {
+    // rules in order.  If a rule matches a given cell, we save the
+    // appropriate tile & orientation, then move on to the next cell.  If no
+    // rules match, we don't output anything for that cell.
+    for (const auto &iter : cell_map) {
+        HexMapCellId::Key key = iter.key;
         HexMapCellId cell_id = key;
-        int32_t cells[Rule::PATTERN_CELLS];
+        int32_t values[Rule::PATTERN_CELLS];
         for (int i = 0; i < Rule::PATTERN_CELLS; i++) {
             // if the cell isn't set in the cell mask, don't get the value for
             // that cell.
             if ((cell_mask & (1ULL << i)) == 0) {
-                cells[i] = -1;
+                values[i] = -1;
                 continue;
             }
-            uint16_t *ptr =
-                    int_node->cell_map.getptr(cell_id + Rule::CellOffsets[i]);
-            cells[i] = ptr ? *ptr : -1;
+            const uint16_t *ptr = cells.getptr(cell_id + Rule::CellOffsets[i]);
+            values[i] = ptr ? *ptr : -1;
         }
         for (int id : rules_order) {
-            Rule &rule = rules[id];
+            const Rule &rule = rules[id];
 
             if (!rule.enabled) {
                 continue;
@@ -368,22 +363,72 @@ void HexMapAutoTiledNode::apply_rules() {
 
             // Try to match the cell
             HexMapTileOrientation orientation;
-            if (rule.match(cells, orientation)) {
-                // cell matches; set the cell in the tiled node using the
-                // matched orientation
-                cell_state[HexMapNode::CELL_ARRAY_INDEX_VEC] =
-                        cell_id.to_vec();
-                cell_state[HexMapNode::CELL_ARRAY_INDEX_VALUE] = rule.tile;
-                cell_state[HexMapNode::CELL_ARRAY_INDEX_ORIENTATION] =
-                        static_cast<int>(orientation);
-                output.append_array(cell_state);
+            if (rule.match(values, orientation)) {
+                // cell matches; save the tile & matched orientation
+                out.push_back(RuleMatch{
+                        .cell = key,
+                        .tile = rule.tile,
+                        .orientation = orientation,
+                });
                 break;
             }
         }
     }
 
+    return cell_map.size();
+}
+
+void HexMapAutoTiledNode::apply_rules() {
+    ERR_FAIL_NULL(int_node);
+    ERR_FAIL_NULL(tiled_node);
+    uint64_t start_usec = Time::get_singleton()->get_ticks_usec();
+
+    tiled_node->clear();
+
+    LocalVector<RuleMatch> matches;
+    unsigned cells_evaluated =
+            match_rules(int_node->cell_map, rules, rules_order, matches);
+
+    // To reduce the signals produced from TiledNode::set_cell(), we're going
+    // to build an Array of cells to set to set_cells().
+    Array output;
+    Array cell_state;
+    cell_state.resize(HexMapNode::CELL_ARRAY_WIDTH);
+    static_assert(HexMapNode::CELL_ARRAY_INDEX_VEC == 0);
+    static_assert(HexMapNode::CELL_ARRAY_INDEX_VALUE == 1);
+    static_assert(HexMapNode::CELL_ARRAY_INDEX_ORIENTATION == 2);
+    for (const RuleMatch &match : matches) {
+        cell_state[HexMapNode::CELL_ARRAY_INDEX_VEC] =
+                HexMapCellId(match.cell).to_vec();
+        cell_state[HexMapNode::CELL_ARRAY_INDEX_VALUE] = match.tile;
+        cell_state[HexMapNode::CELL_ARRAY_INDEX_ORIENTATION] =
+                static_cast<int>(match.orientation);
+        output.append_array(cell_state);
+    }
+
     // now apply all the changes
     tiled_node->set_cells(output);
+
+    monitor_apply_rules_usec.set(
+            Time::get_singleton()->get_ticks_usec() - start_usec);
+    monitor_cells_evaluated.set(cells_evaluated);
+}
+
+Dictionary HexMapAutoTiledNode::get_memory_usage() const {
+    Dictionary out;
+    int64_t rule_bytes = ::get_memory_usage(rules);
+    int64_t order_bytes = ::get_memory_usage(rules_order);
+    out["rules"] = rule_bytes;
+    out["rules_order"] = order_bytes;
+
+    int64_t total = rule_bytes + order_bytes;
+    if (tiled_node != nullptr) {
+        Dictionary tiled_usage = tiled_node->get_memory_usage();
+        out["tiled_node"] = tiled_usage;
+        total += (int64_t)tiled_usage["total"];
+    }
+    out["total"] = total;
+    return out;
 }
 
 HexMapTiledNode *HexMapAutoTiledNode::get_tiled_node() const {
@@ -438,6 +483,8 @@ void HexMapAutoTiledNode::_bind_methods() {
 
     ClassDB::bind_method(
             D_METHOD("get_tiled_node"), &HexMapAutoTiledNode::get_tiled_node);
+    ClassDB::bind_method(D_METHOD("get_memory_usage"),
+            &HexMapAutoTiledNode::get_memory_usage);
 
     ADD_SIGNAL(MethodInfo("rules_changed"));
 }
@@ -531,7 +578,7 @@ void HexMapAutoTiledNode::Rule::set_cell_empty(HexMapCellId offset,
     update_internal();
 }
 
-inline bool HexMapAutoTiledNode::Rule::match(
+bool HexMapAutoTiledNode::Rule::match(
         const int32_t cell_value[PATTERN_CELLS],
         HexMapTileOrientation &orientation) const {
     // start with zero rotation, and try matching the rule with each
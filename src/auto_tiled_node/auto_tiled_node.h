@@ -8,6 +8,8 @@
 #include <godot_cpp/classes/wrapped.hpp>
 #include <godot_cpp/core/property_info.hpp>
 #include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/templates/safe_refcount.hpp>
 #include <godot_cpp/variant/dictionary.hpp>
 
 #include "core/tile_orientation.h"
@@ -33,13 +35,13 @@ public:
     class Rule {
         friend HexMapAutoTiledNode;
 
-        /// number of cells contained in the rule pattern
-        static const unsigned PATTERN_CELLS = 35;
-
         /// rule id used to denote that the rule does not have an id
         static const uint16_t ID_NOT_SET = USHRT_MAX;
 
     public:
+        /// number of cells contained in the rule pattern
+        static const unsigned PATTERN_CELLS = 35;
+
         /// rule cell states
         enum CellState : uint8_t {
             /// cell is ignored when matching this rule
@@ -93,10 +95,9 @@ public:
         /// @param[out] [orientation] first orientation found where rule
         ///     matches
         /// @return true if rule matches
-        inline bool match(const int32_t cell_values[PATTERN_CELLS],
+        bool match(const int32_t cell_values[PATTERN_CELLS],
                 HexMapTileOrientation &orientation) const;
 
-    private:
         // clang-format off
 
         /// offset of each cell in the rule pattern from the origin cell
@@ -160,6 +161,7 @@ public:
             HexMapCellId(-2,  1, 0),    // 34
         };
 
+    private:
         /// Used to rotate the cell pattern based on TileOrientation, each
         /// array is a specific tile orientation, and the values within the
         /// array are the pattern index for each cell we're matching against.
@@ -302,6 +304,31 @@ public:
         static void _bind_methods();
     };
 
+    /// Performance monitor counters for the most recent apply_rules() across
+    /// all AutoTiledNode instances; time taken in microseconds, and the
+    /// number of cells the rules were evaluated against.
+    static SafeNumeric<uint64_t> monitor_apply_rules_usec;
+    static SafeNumeric<int64_t> monitor_cells_evaluated;
+
+    /// tile selected for a cell by match_rules()
+    struct RuleMatch {
+        HexMapCellId::Key cell;
+        int16_t tile;
+        HexMapTileOrientation orientation;
+    };
+
+    /// Apply rules to IntNode cells, and return the tile for each matched
+    /// cell.  This is the core of apply_rules(), without touching any nodes.
+    /// @param [cells] IntNode cell values
+    /// @param [rules] rules by id
+    /// @param [rules_order] ids of the rules to try, in order
+    /// @param [out] cleared, then populated with the matched cells
+    /// @return number of cells the rules were evaluated against
+    static unsigned match_rules(const HexMapIntNode::CellMap &cells,
+            const HashMap<uint16_t, Rule> &rules,
+            const Vector<int> &rules_order,
+            LocalVector<RuleMatch> &out);
+
     HexMapAutoTiledNode();
     ~HexMapAutoTiledNode();
 
@@ -334,6 +361,10 @@ public:
     /// @return HexMapTiledNode
     HexMapTiledNode *get_tiled_node() const;
 
+    /// estimate the memory used by the rules, and the internal
+    /// HexMapTiledNode; see HexMapNode::get_memory_usage()
+    Dictionary get_memory_usage() const;
+
     // signal callbacks
     void on_int_node_hex_space_changed();
 
@@ -1,5 +1,6 @@
 #include <cassert>
 #include <climits>
+#include <cmath>
 #include <godot_cpp/classes/global_constants.hpp>
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/core/error_macros.hpp>
@@ -10,10 +11,20 @@
 
 #include "cell_id.h"
 #include "iter_radial.h"
+#include "iter_ring.h"
+#include "iter_spiral.h"
 #include "math.h"
 
 const HexMapCellId HexMapCellId::ZERO(0, 0, 0);
 const HexMapCellId HexMapCellId::INVALID(INT_MAX, INT_MAX, INT_MAX);
+const HexMapCellId HexMapCellId::DIRECTIONS[6] = {
+    HexMapCellId(1, 0, 0),
+    HexMapCellId(1, -1, 0),
+    HexMapCellId(0, -1, 0),
+    HexMapCellId(-1, 0, 0),
+    HexMapCellId(-1, 1, 0),
+    HexMapCellId(0, 1, 0),
+};
 
 /// return a Ref<T> wrapped copy of this HexMapCellId
 Ref<hex_bind::HexMapCellId> HexMapCellId::to_ref() const {
@@ -21,30 +32,34 @@ Ref<hex_bind::HexMapCellId> HexMapCellId::to_ref() const {
 }
 
 // based on blog post https://observablehq.com/@jrus/hexround
-static inline HexMapCellId axial_round(real_t q_in, real_t r_in) {
-    int q = round(q_in);
-    int r = round(r_in);
+HexMapCellId HexMapCellId::axial_round(real_t q_in, real_t r_in) {
+    real_t q = std::round(q_in);
+    real_t r = std::round(r_in);
 
     real_t q_rem = q_in - q;
     real_t r_rem = r_in - r;
 
-    if (abs(q_rem) >= abs(r_rem)) {
-        q += round(0.5 * r_rem + q_rem);
+    if (std::abs(q_rem) >= std::abs(r_rem)) {
+        q += std::round((real_t)0.5 * r_rem + q_rem);
     } else {
-        r += round(0.5 * q_rem + r_rem);
+        r += std::round((real_t)0.5 * q_rem + r_rem);
     }
 
-    return HexMapCellId(q, r, 0);
+    return HexMapCellId((int)q, (int)r, 0);
 }
 
 HexMapCellId HexMapCellId::from_unit_point(const Vector3 &point) {
     // convert x/z point into axial hex coordinates
     // https://www.redblobgames.com/grids/hexagons/#pixel-to-hex
-    real_t q = (Math_SQRT3 / 3 * point.x - 1.0 / 3 * point.z);
-    real_t r = (2.0 / 3 * point.z);
+    //
+    // HexMapSpace::get_cell_ids() repeats these steps with SSE2, so keep the
+    // math in real_t for the two to round the same way.
+    real_t q =
+            (real_t)(Math_SQRT3 / 3) * point.x - (real_t)(1.0 / 3) * point.z;
+    real_t r = (real_t)(2.0 / 3) * point.z;
     HexMapCellId cell_id = axial_round(q, r);
 
-    cell_id.y = round(point.y);
+    cell_id.y = (int)std::round(point.y);
 
     return cell_id;
 }
@@ -69,6 +84,72 @@ unsigned HexMapCellId::distance(const HexMapCellId &other) const {
     return hex_dist + y_dist;
 }
 
+void HexMapCellId::get_line(const HexMapCellId &to,
+        LocalVector<HexMapCellId> &out) const {
+    HexMapCellId delta = to - *this;
+    unsigned hex_steps =
+            (ABS(delta.q) + ABS(delta.q + delta.r) + ABS(delta.r)) / 2;
+    unsigned y_steps = ABS(delta.y);
+    int y_dir = delta.y < 0 ? -1 : 1;
+
+    out.clear();
+    out.reserve(hex_steps + y_steps + 1);
+    out.push_back(*this);
+
+    // Every step moves through a single face, so the line can never slip
+    // between two cells that share an edge or a corner.  The horizontal
+    // path is the hex line between the two columns: interpolate between the
+    // column centers and round each point back to a cell.  The points are
+    // nudged off the cell edges so the line doesn't flip between neighbors
+    // when it runs exactly along an edge.
+    // https://www.redblobgames.com/grids/hexagons/#line-drawing
+    Vector3 nudge(1e-6, 0, 2e-6);
+    Vector3 from_center = HexMapCellId(q, r, 0).unit_center() + nudge;
+    Vector3 to_center = HexMapCellId(to.q, to.r, 0).unit_center() + nudge;
+
+    // The layer changes are merged into the horizontal path in the order
+    // the line crosses the boundaries: into the next column at
+    // t = (h + 0.5) / hex_steps, and into the next layer at
+    // t = (v + 0.5) / y_steps.  When the line passes exactly through the
+    // corner, the horizontal step is taken first.
+    HexMapCellId cell = *this;
+    unsigned h = 0, v = 0;
+    while (h < hex_steps || v < y_steps) {
+        bool horizontal = v == y_steps ||
+                (h < hex_steps &&
+                        (2 * h + 1) * y_steps <= (2 * v + 1) * hex_steps);
+        if (horizontal) {
+            h++;
+            HexMapCellId column = from_unit_point(
+                    from_center.lerp(to_center, (real_t)h / hex_steps));
+            cell.q = column.q;
+            cell.r = column.r;
+        } else {
+            v++;
+            cell.y += y_dir;
+        }
+        out.push_back(cell);
+    }
+}
+
+void HexMapCellId::get_ring(unsigned radius,
+        LocalVector<HexMapCellId> &out) const {
+    out.clear();
+    out.reserve(radius == 0 ? 1 : radius * 6);
+    for (const HexMapCellId &cell : HexMapIterRing(*this, radius)) {
+        out.push_back(cell);
+    }
+}
+
+void HexMapCellId::get_spiral(unsigned radius,
+        LocalVector<HexMapCellId> &out) const {
+    out.clear();
+    out.reserve(3 * radius * (radius + 1) + 1);
+    for (const HexMapCellId &cell : HexMapIterSpiral(*this, radius)) {
+        out.push_back(cell);
+    }
+}
+
 HexMapIterRadial HexMapCellId::get_neighbors(unsigned int radius,
         const HexMapPlanes &planes,
         bool include_center) const {
@@ -177,6 +258,20 @@ void hex_bind::HexMapCellId::_bind_methods() {
             &hex_bind::HexMapCellId::get_neighbors,
             1,
             false);
+    ClassDB::bind_method(
+            D_METHOD("get_neighbor_vecs", "radius", "include_self"),
+            &hex_bind::HexMapCellId::get_neighbor_vecs,
+            DEFVAL(1),
+            DEFVAL(false));
+    ClassDB::bind_method(D_METHOD("get_ring_vecs", "radius"),
+            &hex_bind::HexMapCellId::get_ring_vecs);
+    ClassDB::bind_method(D_METHOD("get_spiral_vecs", "radius"),
+            &hex_bind::HexMapCellId::get_spiral_vecs);
+    ClassDB::bind_method(D_METHOD("get_line_vecs", "to"),
+            &hex_bind::HexMapCellId::get_line_vecs);
+    ClassDB::bind_static_method("HexMapCellId",
+            D_METHOD("vecs_to_keys", "vecs"),
+            &hex_bind::HexMapCellId::vecs_to_keys);
 
     ClassDB::bind_method(
             D_METHOD("add", "other"), &hex_bind::HexMapCellId::add);
@@ -272,6 +367,52 @@ Ref<hex_bind::HexMapIter> hex_bind::HexMapCellId::get_neighbors(
             .to_ref();
 }
 
+PackedVector3Array hex_bind::HexMapCellId::get_neighbor_vecs(
+        unsigned int radius,
+        bool include_center) const {
+    PackedVector3Array out;
+    for (const CellId &cell :
+            inner.get_neighbors(radius, HexMapPlanes::All, include_center)) {
+        out.push_back(Vector3(cell.to_vec()));
+    }
+    return out;
+}
+
+PackedVector3Array hex_bind::HexMapCellId::get_ring_vecs(
+        unsigned int radius) const {
+    LocalVector<CellId> cells;
+    inner.get_ring(radius, cells);
+    return CellId::to_packed_vecs(cells);
+}
+
+PackedVector3Array hex_bind::HexMapCellId::get_spiral_vecs(
+        unsigned int radius) const {
+    LocalVector<CellId> cells;
+    inner.get_spiral(radius, cells);
+    return CellId::to_packed_vecs(cells);
+}
+
+PackedVector3Array hex_bind::HexMapCellId::get_line_vecs(
+        Ref<hex_bind::HexMapCellId> to) const {
+    ERR_FAIL_COND_V_MSG(!to.is_valid(),
+            PackedVector3Array(),
+            "argument is not a HexMapCellId");
+    LocalVector<CellId> cells;
+    inner.get_line(to->inner, cells);
+    return CellId::to_packed_vecs(cells);
+}
+
+PackedInt64Array hex_bind::HexMapCellId::vecs_to_keys(
+        const PackedVector3Array &vecs) {
+    PackedInt64Array out;
+    out.resize(vecs.size());
+    int64_t *ptr = out.ptrw();
+    for (int i = 0; i < vecs.size(); i++) {
+        ptr[i] = CellId::Key(CellId(Vector3i(vecs[i]))).key;
+    }
+    return out;
+}
+
 Ref<hex_bind::HexMapCellId> hex_bind::HexMapCellId::add(
         Ref<hex_bind::HexMapCellId> other) const {
     ERR_FAIL_COND_V_MSG(!other.is_valid(),
@@ -6,10 +6,13 @@
 #include <godot_cpp/classes/wrapped.hpp>
 #include <godot_cpp/core/defs.hpp>
 #include <godot_cpp/templates/hashfuncs.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/packed_int64_array.hpp>
 #include <godot_cpp/variant/packed_vector3_array.hpp>
 #include <godot_cpp/variant/variant.hpp>
 #include <godot_cpp/variant/vector3.hpp>
 
+#include "morton.h"
 #include "planes.h"
 
 using namespace godot;
@@ -57,6 +60,21 @@ public:
             return Vector3i(q, y, r);
         }
         _FORCE_INLINE_ Key get_cell_above() const { return Key(q, r, y + 1); }
+
+        /// Z-order (morton) code for the key.  Sorting keys by this value
+        /// keeps cells that are near each other in space near each other in
+        /// memory.  The sign bit of each coordinate is flipped so that the
+        /// codes sort in coordinate order.
+        _FORCE_INLINE_ uint64_t to_morton() const {
+            return morton3_encode((uint16_t)q ^ 0x8000,
+                    (uint16_t)r ^ 0x8000,
+                    (uint16_t)y ^ 0x8000);
+        }
+        static _FORCE_INLINE_ Key from_morton(uint64_t code) {
+            uint16_t q, r, y;
+            morton3_decode(code, q, r, y);
+            return Key(q ^ 0x8000, r ^ 0x8000, y ^ 0x8000);
+        }
     };
 
     // axial coordinates
@@ -118,6 +136,19 @@ public:
             const HexMapPlanes &planes = HexMapPlanes::All,
             bool include_center = false) const;
 
+    // get the cells exactly `radius` away in the same layer, and the cells
+    // within `radius` in the same layer ordered ring by ring, starting with
+    // this cell; `out` is cleared first so it can be reused.
+    void get_ring(unsigned radius, LocalVector<HexMapCellId> &out) const;
+    void get_spiral(unsigned radius, LocalVector<HexMapCellId> &out) const;
+
+    // get the cells along a straight line from this cell to another,
+    // including both ends; `out` is cleared first so it can be reused.
+    // Consecutive cells always share a face, so the line has
+    // `distance(to) + 1` cells.
+    void get_line(const HexMapCellId &to,
+            LocalVector<HexMapCellId> &out) const;
+
     // get the pixel center of this cell assuming the cell is a unit cell with
     // height = 1, radius = 1.  Use HexMap.get_cell_center() for center scaled
     // by cell size.
@@ -126,6 +157,9 @@ public:
     // get a cell id for a point on a unit hex grid (height=1, radius-1)
     static HexMapCellId from_unit_point(const Vector3 &point);
 
+    // round fractional axial coordinates to the nearest cell, with y = 0
+    static HexMapCellId axial_round(real_t q, real_t r);
+
     // convert to odd-r coordinates
     // https://www.redblobgames.com/grids/hexagons/#conversions-offset
     _FORCE_INLINE_ Vector3i to_oddr() const {
@@ -146,8 +180,25 @@ public:
     HexMapCellId rotate(int steps,
             HexMapCellId center = HexMapCellId(0, 0, 0)) const;
 
+    // pack a list of cell ids into a PackedVector3Array of Vector3i values
+    template <typename T>
+    static PackedVector3Array to_packed_vecs(const T &cells) {
+        PackedVector3Array out;
+        out.resize(cells.size());
+        Vector3 *ptr = out.ptrw();
+        int i = 0;
+        for (const HexMapCellId &cell : cells) {
+            ptr[i++] = Vector3(cell.to_vec());
+        }
+        return out;
+    }
+
     static const HexMapCellId ZERO;
     static const HexMapCellId INVALID;
+
+    /// offsets to the six neighbors in the same layer; east, northeast,
+    /// northwest, west, southwest, southeast
+    static const HexMapCellId DIRECTIONS[6];
 };
 
 // added for testing
@@ -215,6 +266,17 @@ public:
     Ref<hex_bind::HexMapIter> get_neighbors(unsigned int radius = 1,
             bool include_self = false) const;
 
+    // packed variants of the neighbor queries; these return the cell ids as
+    // Vector3i values in a single allocation instead of one Ref per cell.
+    PackedVector3Array get_neighbor_vecs(unsigned int radius = 1,
+            bool include_self = false) const;
+    PackedVector3Array get_ring_vecs(unsigned int radius) const;
+    PackedVector3Array get_spiral_vecs(unsigned int radius) const;
+    PackedVector3Array get_line_vecs(Ref<hex_bind::HexMapCellId> to) const;
+
+    // convert packed Vector3i cell ids into as_int() keys
+    static PackedInt64Array vecs_to_keys(const PackedVector3Array &vecs);
+
 protected:
     static void _bind_methods();
 };
@@ -0,0 +1,416 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <godot_cpp/core/defs.hpp>
+#include <godot_cpp/core/error_macros.hpp>
+#include <godot_cpp/core/memory.hpp>
+#include <new>
+#include <type_traits>
+
+// define HEX_MAP_CELL_MAP_NO_SSE2 to force the portable group matching
+#if (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)) && \
+        !defined(HEX_MAP_CELL_MAP_NO_SSE2)
+#include <emmintrin.h>
+#define HEX_MAP_CELL_MAP_SSE2
+#endif
+
+#include "cell_id.h"
+
+using namespace godot;
+
+/// Open-addressing hash map from HexMapCellId::Key to a small trivially
+/// copyable value.
+///
+/// This is a flat table in the style of SwissTable: every slot has a control
+/// byte holding 7 bits of the key hash (or empty/deleted), and the slots are
+/// probed 16 at a time by comparing a group of control bytes at once (SSE2
+/// where available).  Keys & values are stored inline in a single
+/// allocation, so lookups touch at most a couple of cache lines, and there
+/// is no per-element allocation like HashMap.
+///
+/// The API is the subset of godot HashMap used for the cell maps.
+/// Iteration order is unspecified, and pointers to values are invalidated
+/// when the map grows.
+template <typename V>
+class HexMapCellMap {
+public:
+    using Key = HexMapCellId::Key;
+
+    static_assert(std::is_trivially_copyable<V>::value,
+            "HexMapCellMap values must be trivially copyable");
+
+    struct Element {
+        Key key;
+        V value;
+    };
+
+    template <typename E>
+    class IteratorBase {
+    public:
+        _FORCE_INLINE_ E &operator*() const { return map->slots[index]; }
+        _FORCE_INLINE_ E *operator->() const { return &map->slots[index]; }
+        _FORCE_INLINE_ IteratorBase &operator++() {
+            index = map->next_full(index + 1);
+            return *this;
+        }
+        _FORCE_INLINE_ bool operator!=(const IteratorBase &other) const {
+            return index != other.index;
+        }
+        _FORCE_INLINE_ bool operator==(const IteratorBase &other) const {
+            return index == other.index;
+        }
+
+    private:
+        friend HexMapCellMap;
+        IteratorBase(const HexMapCellMap *map, uint32_t index) :
+                map(map), index(index) {}
+        const HexMapCellMap *map;
+        uint32_t index;
+    };
+    using Iterator = IteratorBase<Element>;
+    using ConstIterator = IteratorBase<const Element>;
+
+    HexMapCellMap() {}
+    HexMapCellMap(const HexMapCellMap &other) { copy_from(other); }
+    HexMapCellMap(HexMapCellMap &&other) { take(other); }
+    ~HexMapCellMap() { free_table(); }
+
+    HexMapCellMap &operator=(const HexMapCellMap &other) {
+        if (this != &other) {
+            free_table();
+            copy_from(other);
+        }
+        return *this;
+    }
+    HexMapCellMap &operator=(HexMapCellMap &&other) {
+        if (this != &other) {
+            free_table();
+            take(other);
+        }
+        return *this;
+    }
+
+    _FORCE_INLINE_ uint32_t size() const { return count; }
+    _FORCE_INLINE_ bool is_empty() const { return count == 0; }
+    _FORCE_INLINE_ uint32_t get_capacity() const { return capacity; }
+
+    /// bytes allocated for the table
+    _FORCE_INLINE_ size_t get_allocated_size() const {
+        return capacity == 0 ? 0 : get_table_size(capacity);
+    }
+
+    _FORCE_INLINE_ V *getptr(Key key) {
+        uint32_t index = find(key);
+        return index == NOT_FOUND ? nullptr : &slots[index].value;
+    }
+    _FORCE_INLINE_ const V *getptr(Key key) const {
+        uint32_t index = find(key);
+        return index == NOT_FOUND ? nullptr : &slots[index].value;
+    }
+    _FORCE_INLINE_ bool has(Key key) const { return find(key) != NOT_FOUND; }
+
+    /// insert or replace the value for `key`
+    Element *insert(Key key, const V &value) {
+        Element *element = find_or_insert(key);
+        element->value = value;
+        return element;
+    }
+
+    /// get the value for `key`, inserting a default value if it is missing
+    V &operator[](Key key) {
+        uint32_t index = find(key);
+        if (index != NOT_FOUND) {
+            return slots[index].value;
+        }
+        return insert(key, V())->value;
+    }
+    const V &operator[](Key key) const {
+        const V *value = getptr(key);
+        CRASH_COND_MSG(value == nullptr, "HexMapCellMap: key not found");
+        return *value;
+    }
+
+    bool erase(Key key) {
+        uint32_t index = find(key);
+        if (index == NOT_FOUND) {
+            return false;
+        }
+        // Leave a tombstone so probe sequences passing through this slot
+        // keep going.  Tombstones are reused by insert(), and dropped when
+        // the table is rehashed.
+        set_ctrl(index, CTRL_DELETED);
+        count--;
+        return true;
+    }
+
+    /// remove all elements, keeping the allocated table
+    void clear() {
+        if (capacity == 0) {
+            return;
+        }
+        memset(ctrl, CTRL_EMPTY, capacity + GROUP_WIDTH);
+        count = 0;
+        growth_left = max_load(capacity);
+    }
+
+    /// make room for at least `elements` without rehashing
+    void reserve(uint32_t elements) {
+        if (elements > count + growth_left) {
+            rehash(capacity_for(elements));
+        }
+    }
+
+    _FORCE_INLINE_ Iterator begin() { return Iterator(this, next_full(0)); }
+    _FORCE_INLINE_ Iterator end() { return Iterator(this, capacity); }
+    _FORCE_INLINE_ ConstIterator begin() const {
+        return ConstIterator(this, next_full(0));
+    }
+    _FORCE_INLINE_ ConstIterator end() const {
+        return ConstIterator(this, capacity);
+    }
+
+private:
+    // control byte values; full slots hold the top 7 bits of the hash
+    static constexpr int8_t CTRL_EMPTY = -128;
+    static constexpr int8_t CTRL_DELETED = -2;
+    static constexpr uint32_t GROUP_WIDTH = 16;
+    static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+
+    // `capacity` control bytes, followed by a copy of the first GROUP_WIDTH
+    // control bytes so that a group can be loaded at any slot without
+    // wrapping.
+    int8_t *ctrl = nullptr;
+    Element *slots = nullptr;
+    uint32_t capacity = 0;
+    uint32_t count = 0;
+    // inserts into empty slots allowed before the table must grow
+    uint32_t growth_left = 0;
+
+    // The key fields are packed 16-bits each, so mix them together before
+    // using the low bits for the slot, and the high bits for the control
+    // byte.
+    static _FORCE_INLINE_ uint64_t hash(Key key) {
+        uint64_t h = key.key;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return h;
+    }
+    static _FORCE_INLINE_ int8_t hash_ctrl(uint64_t h) {
+        return (int8_t)(h >> 57);
+    }
+
+    // keep the load at or below 7/8
+    static _FORCE_INLINE_ uint32_t max_load(uint32_t slot_count) {
+        return slot_count - slot_count / 8;
+    }
+    static uint32_t capacity_for(uint32_t elements) {
+        uint32_t slot_count = GROUP_WIDTH;
+        while (max_load(slot_count) < elements) {
+            slot_count *= 2;
+        }
+        return slot_count;
+    }
+    static _FORCE_INLINE_ size_t get_ctrl_size(uint32_t slot_count) {
+        size_t size = slot_count + GROUP_WIDTH;
+        return (size + alignof(Element) - 1) & ~(alignof(Element) - 1);
+    }
+    static _FORCE_INLINE_ size_t get_table_size(uint32_t slot_count) {
+        return get_ctrl_size(slot_count) + slot_count * sizeof(Element);
+    }
+
+    // bit mask of the slots in the group at `pos` whose control byte
+    // matches `value`
+    _FORCE_INLINE_ uint32_t match(uint32_t pos, int8_t value) const {
+#ifdef HEX_MAP_CELL_MAP_SSE2
+        __m128i group = _mm_loadu_si128((const __m128i *)(ctrl + pos));
+        return _mm_movemask_epi8(
+                _mm_cmpeq_epi8(group, _mm_set1_epi8(value)));
+#else
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < GROUP_WIDTH; i++) {
+            mask |= (uint32_t)(ctrl[pos + i] == value) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // bit mask of the empty or deleted slots in the group at `pos`
+    _FORCE_INLINE_ uint32_t match_empty_or_deleted(uint32_t pos) const {
+#ifdef HEX_MAP_CELL_MAP_SSE2
+        // only the special values are below -1
+        __m128i group = _mm_loadu_si128((const __m128i *)(ctrl + pos));
+        return _mm_movemask_epi8(
+                _mm_cmpgt_epi8(_mm_set1_epi8(-1), group));
+#else
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < GROUP_WIDTH; i++) {
+            mask |= (uint32_t)(ctrl[pos + i] < -1) << i;
+        }
+        return mask;
+#endif
+    }
+
+    static _FORCE_INLINE_ uint32_t lowest_bit(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctz(mask);
+#else
+        uint32_t bit = 0;
+        while ((mask & 1) == 0) {
+            mask >>= 1;
+            bit++;
+        }
+        return bit;
+#endif
+    }
+
+    _FORCE_INLINE_ void set_ctrl(uint32_t index, int8_t value) {
+        ctrl[index] = value;
+        if (index < GROUP_WIDTH) {
+            ctrl[capacity + index] = value;
+        }
+    }
+
+    // Probe the groups along the triangular sequence for the key.  With a
+    // power of two capacity, this visits every group before repeating.
+    uint32_t find(Key key) const {
+        if (count == 0) {
+            return NOT_FOUND;
+        }
+        uint64_t h = hash(key);
+        int8_t h2 = hash_ctrl(h);
+        uint32_t mask = capacity - 1;
+        uint32_t pos = h & mask;
+        for (uint32_t step = GROUP_WIDTH;; step += GROUP_WIDTH) {
+            for (uint32_t bits = match(pos, h2); bits; bits &= bits - 1) {
+                uint32_t index = (pos + lowest_bit(bits)) & mask;
+                if (slots[index].key == key) {
+                    return index;
+                }
+            }
+            if (match(pos, CTRL_EMPTY)) {
+                return NOT_FOUND;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    // first empty or deleted slot along the probe sequence for `h`
+    uint32_t find_free(uint64_t h) const {
+        uint32_t mask = capacity - 1;
+        uint32_t pos = h & mask;
+        for (uint32_t step = GROUP_WIDTH;; step += GROUP_WIDTH) {
+            uint32_t bits = match_empty_or_deleted(pos);
+            if (bits) {
+                return (pos + lowest_bit(bits)) & mask;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    Element *find_or_insert(Key key) {
+        uint32_t index = find(key);
+        if (index != NOT_FOUND) {
+            return &slots[index];
+        }
+
+        if (growth_left == 0) {
+            // If at least half of the used slots are tombstones, rehashing
+            // at the same capacity is enough to reclaim them.
+            if (capacity == 0) {
+                rehash(GROUP_WIDTH);
+            } else if (count * 2 <= max_load(capacity)) {
+                rehash(capacity);
+            } else {
+                rehash(capacity * 2);
+            }
+        }
+
+        uint64_t h = hash(key);
+        index = find_free(h);
+        if (ctrl[index] == CTRL_EMPTY) {
+            growth_left--;
+        }
+        set_ctrl(index, hash_ctrl(h));
+        new (&slots[index]) Element{ key, V() };
+        count++;
+        return &slots[index];
+    }
+
+    void alloc_table(uint32_t new_capacity) {
+        uint8_t *table = (uint8_t *)memalloc(get_table_size(new_capacity));
+        ctrl = (int8_t *)table;
+        slots = (Element *)(table + get_ctrl_size(new_capacity));
+        capacity = new_capacity;
+        count = 0;
+        growth_left = max_load(new_capacity);
+        memset(ctrl, CTRL_EMPTY, new_capacity + GROUP_WIDTH);
+    }
+
+    void free_table() {
+        if (ctrl != nullptr) {
+            memfree(ctrl);
+        }
+        ctrl = nullptr;
+        slots = nullptr;
+        capacity = count = growth_left = 0;
+    }
+
+    void rehash(uint32_t new_capacity) {
+        int8_t *old_ctrl = ctrl;
+        Element *old_slots = slots;
+        uint32_t old_capacity = capacity;
+
+        alloc_table(new_capacity);
+        for (uint32_t i = 0; i < old_capacity; i++) {
+            if (old_ctrl[i] < 0) {
+                continue;
+            }
+            uint64_t h = hash(old_slots[i].key);
+            uint32_t index = find_free(h);
+            set_ctrl(index, hash_ctrl(h));
+            new (&slots[index]) Element(old_slots[i]);
+            count++;
+        }
+        growth_left -= count;
+
+        if (old_ctrl != nullptr) {
+            memfree(old_ctrl);
+        }
+    }
+
+    _FORCE_INLINE_ uint32_t next_full(uint32_t index) const {
+        while (index < capacity && ctrl[index] < 0) {
+            index++;
+        }
+        return index;
+    }
+
+    void copy_from(const HexMapCellMap &other) {
+        if (other.capacity == 0) {
+            return;
+        }
+        alloc_table(other.capacity);
+        memcpy((void *)ctrl, other.ctrl, get_table_size(capacity));
+        count = other.count;
+        growth_left = other.growth_left;
+    }
+
+    void take(HexMapCellMap &other) {
+        ctrl = other.ctrl;
+        slots = other.slots;
+        capacity = other.capacity;
+        count = other.count;
+        growth_left = other.growth_left;
+        other.ctrl = nullptr;
+        other.slots = nullptr;
+        other.capacity = other.count = other.growth_left = 0;
+    }
+};
+
+/// value type for HexMapCellSet
+struct HexMapCellSetValue {};
+
+/// set of cells; iterate with `iter.key`
+using HexMapCellSet = HexMapCellMap<HexMapCellSetValue>;
@@ -143,11 +143,11 @@ Array SelectionManager::get_cell_vecs() const {
 void SelectionManager::set_space(HexMapSpace space) {
     bool redraw = space.get_cell_scale() !=
             mesh_manager.get_space().get_cell_scale();
+    // set_space() applies the new global transform to the existing meshes;
+    // we only need to rebuild them when the cell scale changes.
     mesh_manager.set_space(space);
     if (redraw) {
         redraw_selection();
-    } else {
-        mesh_manager.refresh();
     }
 }
 
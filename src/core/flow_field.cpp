@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <godot_cpp/classes/worker_thread_pool.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/error_macros.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+
+#include "flow_field.h"
+#include "profiling.h"
+
+void HexMapFlowField::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("is_ready"), &HexMapFlowField::is_ready);
+    ClassDB::bind_method(D_METHOD("wait"), &HexMapFlowField::wait);
+    ClassDB::bind_method(D_METHOD("get_distance", "cell"),
+            &HexMapFlowField::_get_distance);
+    ClassDB::bind_method(D_METHOD("get_next_cell", "cell"),
+            &HexMapFlowField::_get_next_cell);
+}
+
+HexMapFlowField::Chunk::Chunk() {
+    for (int i = 0; i < CHUNK_CELLS; i++) {
+        distance[i] = Math_INF;
+        direction[i] = DIRECTION_NONE;
+        step[i] = 0;
+    }
+}
+
+HexMapFlowField::~HexMapFlowField() { wait(); }
+
+void HexMapFlowField::start() {
+    ERR_FAIL_COND_MSG(task_id != -1, "flow field already started");
+    task_id = WorkerThreadPool::get_singleton()->add_task(
+            callable_mp(this, &HexMapFlowField::run),
+            false,
+            "HexMapFlowField::run");
+}
+
+bool HexMapFlowField::is_ready() const {
+    return task_id == -1 ||
+            WorkerThreadPool::get_singleton()->is_task_completed(task_id);
+}
+
+void HexMapFlowField::wait() {
+    if (task_id == -1) {
+        return;
+    }
+    WorkerThreadPool::get_singleton()->wait_for_task_completion(task_id);
+    task_id = -1;
+}
+
+void HexMapFlowField::run() {
+    auto profiler = profiling_begin("HexMapFlowField::run()");
+
+    struct OpenEntry {
+        float distance;
+        CellKey key;
+
+        // reversed so the std heap functions build a min-heap
+        inline bool operator<(const OpenEntry &other) const {
+            return distance > other.distance;
+        }
+    };
+    LocalVector<OpenEntry> open;
+
+    auto get_or_insert_chunk = [this](const HexMapCellId &cell) -> Chunk & {
+        CellKey key = get_chunk_key(cell);
+        Chunk *chunk = chunks.getptr(key);
+        if (chunk == nullptr) {
+            chunk = &chunks.insert(key, Chunk())->value;
+        }
+        return *chunk;
+    };
+
+    for (const CellKey &goal : params.goals) {
+        if (!params.costs.has(goal)) {
+            continue;
+        }
+        get_or_insert_chunk(goal).distance[get_chunk_index(goal)] = 0;
+        open.push_back(OpenEntry{ .distance = 0, .key = goal });
+    }
+
+    // Dijkstra outward from the goals.  The search runs backwards, so for
+    // each cell we look for the cells that could move onto it.
+    while (!open.is_empty()) {
+        std::pop_heap(open.ptr(), open.ptr() + open.size());
+        OpenEntry entry = open[open.size() - 1];
+        open.resize(open.size() - 1);
+
+        // skip stale entries for cells that were reached more cheaply
+        HexMapCellId cell = entry.key;
+        const Chunk *cell_chunk = get_chunk(cell);
+        if (entry.distance > cell_chunk->distance[get_chunk_index(cell)]) {
+            continue;
+        }
+
+        float distance = entry.distance + params.costs[entry.key];
+        if (distance > params.max_distance) {
+            continue;
+        }
+
+        for (int dir = 0; dir < 6; dir++) {
+            HexMapCellId column = cell - HexMapCellId::DIRECTIONS[dir];
+            for (int step = -params.max_step_down; step <= params.max_step_up;
+                    step++) {
+                HexMapCellId prev = column - HexMapCellId(0, 0, step);
+                if (!params.costs.has(prev)) {
+                    continue;
+                }
+
+                Chunk &chunk = get_or_insert_chunk(prev);
+                int index = get_chunk_index(prev);
+                if (distance >= chunk.distance[index]) {
+                    continue;
+                }
+                chunk.distance[index] = distance;
+                chunk.direction[index] = dir;
+                chunk.step[index] = step;
+
+                open.push_back(OpenEntry{ .distance = distance, .key = prev });
+                std::push_heap(open.ptr(), open.ptr() + open.size());
+            }
+        }
+    }
+
+    // the walkable cells are no longer needed
+    params.costs.clear();
+}
+
+const HexMapFlowField::Chunk *HexMapFlowField::get_chunk(
+        const HexMapCellId &cell) const {
+    return chunks.getptr(get_chunk_key(cell));
+}
+
+float HexMapFlowField::get_distance(const HexMapCellId &cell) {
+    wait();
+    const Chunk *chunk = get_chunk(cell);
+    if (chunk == nullptr) {
+        return Math_INF;
+    }
+    return chunk->distance[get_chunk_index(cell)];
+}
+
+float HexMapFlowField::_get_distance(Vector3i cell) {
+    return get_distance(cell);
+}
+
+HexMapCellId HexMapFlowField::get_next_cell(const HexMapCellId &cell) {
+    wait();
+    const Chunk *chunk = get_chunk(cell);
+    if (chunk == nullptr) {
+        return cell;
+    }
+    int index = get_chunk_index(cell);
+    if (chunk->direction[index] == DIRECTION_NONE) {
+        return cell;
+    }
+    return cell + HexMapCellId::DIRECTIONS[chunk->direction[index]] +
+            HexMapCellId(0, 0, chunk->step[index]);
+}
+
+Vector3i HexMapFlowField::_get_next_cell(Vector3i cell) {
+    return get_next_cell(cell);
+}
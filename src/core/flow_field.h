@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/math.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/vector3i.hpp>
+
+#include "cell_id.h"
+
+using namespace godot;
+
+/// Distance to the nearest goal for every reachable cell, and the next cell
+/// to move to along the cheapest path.
+///
+/// Created by `HexMapPathfinder.build_flow_field()`, which snapshots the
+/// walkable cells on the main thread, then runs a multi-source Dijkstra on a
+/// WorkerThreadPool thread.  Any query made before the field is complete
+/// blocks until the worker finishes.  The field is not updated when the map
+/// changes; build a new one.
+class HexMapFlowField : public RefCounted {
+    GDCLASS(HexMapFlowField, RefCounted)
+
+    using CellKey = HexMapCellId::Key;
+    friend class HexMapPathfinder;
+
+public:
+    /// everything the worker needs to build the field
+    struct Params {
+        /// cost of moving onto each walkable cell
+        HashMap<CellKey, float> costs;
+        LocalVector<CellKey> goals;
+        int max_step_up = 1;
+        int max_step_down = 1;
+        /// cells further than this from every goal are left unreachable
+        float max_distance = Math_INF;
+    };
+
+    HexMapFlowField() {};
+    ~HexMapFlowField();
+
+    /// check if the field has been built
+    bool is_ready() const;
+
+    /// block until the field has been built
+    void wait();
+
+    /// cost of the cheapest path from the cell to a goal; INF if the cell
+    /// cannot reach a goal
+    float get_distance(const HexMapCellId &);
+    float _get_distance(Vector3i);
+
+    /// next cell on the cheapest path from the cell to a goal; returns the
+    /// cell itself for goals and for cells that cannot reach a goal
+    HexMapCellId get_next_cell(const HexMapCellId &);
+    Vector3i _get_next_cell(Vector3i);
+
+protected:
+    static void _bind_methods();
+
+private:
+    /// Cells are stored in dense 8x8x8 chunks so neighboring cells share
+    /// cache lines, and lookups only hash the chunk.
+    static constexpr int CHUNK_SHIFT = 3;
+    static constexpr int CHUNK_MASK = (1 << CHUNK_SHIFT) - 1;
+    static constexpr int CHUNK_CELLS = 1 << (CHUNK_SHIFT * 3);
+
+    /// direction value for cells without a next cell
+    static constexpr int8_t DIRECTION_NONE = -1;
+
+    struct Chunk {
+        float distance[CHUNK_CELLS];
+        /// index into `HexMapCellId::DIRECTIONS` of the next cell, and the
+        /// height change to reach it
+        int8_t direction[CHUNK_CELLS];
+        int8_t step[CHUNK_CELLS];
+
+        Chunk();
+    };
+
+    static inline CellKey get_chunk_key(const HexMapCellId &cell) {
+        return CellKey(cell.q >> CHUNK_SHIFT,
+                cell.r >> CHUNK_SHIFT,
+                cell.y >> CHUNK_SHIFT);
+    }
+    static inline int get_chunk_index(const HexMapCellId &cell) {
+        return (cell.q & CHUNK_MASK) |
+                ((cell.r & CHUNK_MASK) << CHUNK_SHIFT) |
+                ((cell.y & CHUNK_MASK) << (CHUNK_SHIFT * 2));
+    }
+
+    /// start building the field from `params` on a worker thread
+    void start();
+
+    /// worker thread entry point
+    void run();
+
+    /// get the chunk containing a cell, or nullptr if it has not been
+    /// reached
+    const Chunk *get_chunk(const HexMapCellId &) const;
+
+    Params params;
+    HashMap<CellKey, Chunk> chunks;
+    int64_t task_id = -1;
+};
@@ -1,3 +1,4 @@
+#include <godot_cpp/classes/worker_thread_pool.hpp>
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/core/error_macros.hpp>
 #include <godot_cpp/core/math.hpp>
@@ -7,6 +8,10 @@
 
 #include "cell_id.h"
 #include "hex_map_node.h"
+#include "iter_radial.h"
+#include "profiling.h"
+#include "raycast.h"
+#include "snapshot.h"
 
 void HexMapNode::_bind_methods() {
     ClassDB::bind_method(D_METHOD("get_space"), &HexMapNode::_get_space);
@@ -49,6 +54,8 @@ void HexMapNode::_bind_methods() {
     ClassDB::bind_method(D_METHOD("find_cell_vecs_by_value", "value"),
             static_cast<Array (HexMapNode::*)(int) const>(
                     &HexMapNode::find_cell_vecs_by_value));
+    ClassDB::bind_method(
+            D_METHOD("get_memory_usage"), &HexMapNode::get_memory_usage);
 
     ClassDB::bind_method(D_METHOD("get_cell_center", "cell_id"),
             static_cast<Vector3 (HexMapNode::*)(
@@ -56,6 +63,12 @@ void HexMapNode::_bind_methods() {
                     &HexMapNode::get_cell_center));
     ClassDB::bind_method(
             D_METHOD("get_cell_id", "local_pos"), &HexMapNode::_get_cell_id);
+    ClassDB::bind_method(D_METHOD("points_to_cell_vecs", "local_points"),
+            &HexMapNode::points_to_cell_vecs);
+    ClassDB::bind_method(D_METHOD("points_to_cell_keys", "local_points"),
+            &HexMapNode::points_to_cell_keys);
+    ClassDB::bind_method(D_METHOD("cell_vecs_to_centers", "cell_vecs"),
+            &HexMapNode::cell_vecs_to_centers);
     ClassDB::bind_method(D_METHOD("get_cell_ids_in_local_quad",
                                  "a",
                                  "b",
@@ -63,6 +76,34 @@ void HexMapNode::_bind_methods() {
                                  "d",
                                  "padding"),
             &HexMapNode::get_cell_ids_in_local_quad);
+    ClassDB::bind_method(D_METHOD("raycast_cells", "from", "to", "max_hits"),
+            &HexMapNode::_raycast_cells,
+            DEFVAL(1));
+    ClassDB::bind_method(
+            D_METHOD("has_line_of_sight", "a", "b", "opaque_values"),
+            &HexMapNode::_has_line_of_sight,
+            DEFVAL(PackedInt32Array()));
+    ClassDB::bind_method(
+            D_METHOD("compute_fov", "origin", "radius", "opaque_values"),
+            &HexMapNode::_compute_fov,
+            DEFVAL(PackedInt32Array()));
+    ClassDB::bind_method(D_METHOD("get_occupied_neighbor_vecs",
+                                 "cell",
+                                 "radius",
+                                 "include_self"),
+            &HexMapNode::get_occupied_neighbor_vecs,
+            DEFVAL(1),
+            DEFVAL(false));
+    ClassDB::bind_method(D_METHOD("get_occupied_ring_vecs", "cell", "radius"),
+            &HexMapNode::get_occupied_ring_vecs);
+    ClassDB::bind_method(D_METHOD("compute_fov_batch",
+                                 "origins",
+                                 "radius",
+                                 "opaque_values"),
+            &HexMapNode::compute_fov_batch,
+            DEFVAL(PackedInt32Array()));
+    ClassDB::bind_method(
+            D_METHOD("get_snapshot"), &HexMapNode::get_snapshot);
 
     ADD_GROUP("Cell", "cell_");
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT,
@@ -90,21 +131,43 @@ void HexMapNode::_bind_methods() {
     BIND_CONSTANT(CELL_VALUE_NONE);
 }
 
+// defined here so the snapshot Ref is destroyed where HexMapSnapshot is a
+// complete type
+HexMapNode::~HexMapNode() {}
+
 void HexMapNode::_notification(int p_what) {
     switch (p_what) {
     case NOTIFICATION_POSTINITIALIZE:
         set_notify_transform(true);
         break;
-    case NOTIFICATION_TRANSFORM_CHANGED:
+    case NOTIFICATION_ENTER_WORLD:
         space.set_transform(get_global_transform());
-        on_hex_space_changed();
         break;
+    case NOTIFICATION_TRANSFORM_CHANGED: {
+        // moving the node does not change the shape of the hex space, so we
+        // don't need subclasses to rebuild everything; let them know only
+        // the transform has changed.
+        Transform3D transform = get_global_transform();
+        if (transform != space.get_transform()) {
+            space.set_transform(transform);
+            on_hex_space_transform_changed();
+        }
+        break;
+    }
     }
 }
 
 void HexMapNode::set_space(const HexMapSpace &value) {
+    if (!(value != space)) {
+        return;
+    }
+    bool scale_changed = value.get_cell_scale() != space.get_cell_scale();
     space = value;
-    on_hex_space_changed();
+    if (scale_changed) {
+        on_hex_space_changed();
+    } else {
+        on_hex_space_transform_changed();
+    }
 }
 
 void HexMapNode::set_space(const Ref<hex_bind::HexMapSpace> &ref) {
@@ -137,6 +200,10 @@ bool HexMapNode::on_hex_space_changed() {
     return true;
 }
 
+void HexMapNode::on_hex_space_transform_changed() {
+    emit_signal("hex_space_changed");
+}
+
 Vector3 HexMapNode::get_cell_center(const HexMapCellId &cell_id) const {
     return space.get_cell_center(cell_id);
 }
@@ -155,6 +222,56 @@ Ref<hex_bind::HexMapCellId> HexMapNode::_get_cell_id(Vector3 pos) const {
     return space.get_cell_id(pos).to_ref();
 }
 
+PackedVector3Array HexMapNode::points_to_cell_vecs(
+        const PackedVector3Array &local_points) const {
+    // convert to full width cell ids; a vector can hold cells beyond the
+    // range of a key
+    LocalVector<HexMapCellId> cells;
+    cells.resize(local_points.size());
+    space.get_cell_ids(local_points.ptr(), cells.size(), cells.ptr());
+
+    PackedVector3Array out;
+    out.resize(cells.size());
+    Vector3 *ptr = out.ptrw();
+    for (unsigned i = 0; i < cells.size(); i++) {
+        ptr[i] = Vector3(cells[i].to_vec());
+    }
+    return out;
+}
+
+PackedInt64Array HexMapNode::points_to_cell_keys(
+        const PackedVector3Array &local_points) const {
+    LocalVector<HexMapCellId> cells;
+    cells.resize(local_points.size());
+    space.get_cell_ids(local_points.ptr(), cells.size(), cells.ptr());
+
+    PackedInt64Array out;
+    out.resize(cells.size());
+    int64_t *ptr = out.ptrw();
+    for (unsigned i = 0; i < cells.size(); i++) {
+        ERR_FAIL_COND_V_MSG(!cells[i].in_bounds(),
+                PackedInt64Array(),
+                "point is outside the range of a cell key: " + cells[i]);
+        ptr[i] = HexMapCellId::Key(cells[i]).key;
+    }
+    return out;
+}
+
+PackedVector3Array HexMapNode::cell_vecs_to_centers(
+        const PackedVector3Array &cell_vecs) const {
+    LocalVector<HexMapCellId::Key> keys;
+    keys.resize(cell_vecs.size());
+    const Vector3 *vecs = cell_vecs.ptr();
+    for (unsigned i = 0; i < keys.size(); i++) {
+        keys[i] = HexMapCellId(Vector3i(vecs[i]));
+    }
+
+    PackedVector3Array out;
+    out.resize(keys.size());
+    space.get_cell_centers(keys.ptr(), keys.size(), out.ptrw());
+    return out;
+}
+
 void HexMapNode::set_cell(const Ref<hex_bind::HexMapCellId> ref,
         int p_item,
         int p_orientation) {
@@ -237,3 +354,219 @@ Array HexMapNode::get_cell_ids_in_local_quad(Vector3 a,
     }
     return out;
 }
+
+Vector<HexMapNode::RaycastHit> HexMapNode::raycast_cells(Vector3 from,
+        Vector3 to,
+        int max_hits) const {
+    Vector<RaycastHit> hits;
+    ERR_FAIL_COND_V_MSG(max_hits < 1, hits, "max_hits must be at least 1");
+
+    // walk the unit grid; side face normals are unchanged by the cell scale
+    // because radius scales x & z equally.
+    Vector3 scale = space.get_cell_scale();
+    HexMapRaycast ray(from / scale, to / scale);
+    do {
+        if (!has(ray.cell)) {
+            continue;
+        }
+        hits.push_back(RaycastHit{
+                .cell_id = ray.cell,
+                .info = get_cell(ray.cell),
+                .point = ray.get_point(ray.entry_t) * scale,
+                .normal = ray.entry_normal,
+        });
+        if (hits.size() >= max_hits) {
+            break;
+        }
+    } while (ray.next());
+
+    return hits;
+}
+
+Array HexMapNode::_raycast_cells(Vector3 from,
+        Vector3 to,
+        int max_hits) const {
+    Vector<RaycastHit> hits = raycast_cells(from, to, max_hits);
+    Array out;
+    out.resize(hits.size());
+    for (int i = 0; i < hits.size(); i++) {
+        const RaycastHit &hit = hits[i];
+        Dictionary dict;
+        dict["cell_id"] = hit.cell_id.to_vec();
+        dict["value"] = hit.info.value;
+        dict["orientation"] = hit.info.orientation;
+        dict["point"] = hit.point;
+        dict["normal"] = hit.normal;
+        out[i] = dict;
+    }
+    return out;
+}
+
+static HashSet<int> to_value_set(const PackedInt32Array &values) {
+    HashSet<int> out;
+    for (int value : values) {
+        out.insert(value);
+    }
+    return out;
+}
+
+bool HexMapNode::is_cell_opaque(const HexMapCellId &cell,
+        const HashSet<int> &opaque_values) const {
+    int value = get_cell(cell).value;
+    if (value == CELL_VALUE_NONE) {
+        return false;
+    }
+    return opaque_values.is_empty() || opaque_values.has(value);
+}
+
+bool HexMapNode::has_line_of_sight(const HexMapCellId &a,
+        const HexMapCellId &b,
+        const HashSet<int> &opaque_values,
+        LocalVector<HexMapCellId> &line) const {
+    a.get_line(b, line);
+    for (uint32_t i = 1; i + 1 < line.size(); i++) {
+        if (is_cell_opaque(line[i], opaque_values)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HexMapNode::has_line_of_sight(const HexMapCellId &a,
+        const HexMapCellId &b,
+        const HashSet<int> &opaque_values) const {
+    LocalVector<HexMapCellId> line;
+    return has_line_of_sight(a, b, opaque_values, line);
+}
+
+bool HexMapNode::_has_line_of_sight(Vector3i a,
+        Vector3i b,
+        const PackedInt32Array &opaque_values) const {
+    return has_line_of_sight(a, b, to_value_set(opaque_values));
+}
+
+Vector<HexMapCellId> HexMapNode::compute_fov(const HexMapCellId &origin,
+        int radius,
+        const HashSet<int> &opaque_values) const {
+    Vector<HexMapCellId> visible;
+    ERR_FAIL_COND_V_MSG(radius < 0, visible, "radius must not be negative");
+
+    LocalVector<HexMapCellId> line;
+    for (const HexMapCellId &cell :
+            origin.get_neighbors(radius, HexMapPlanes::All, true)) {
+        if (has_line_of_sight(origin, cell, opaque_values, line)) {
+            visible.push_back(cell);
+        }
+    }
+    return visible;
+}
+
+PackedVector3Array HexMapNode::_compute_fov(Vector3i origin,
+        int radius,
+        const PackedInt32Array &opaque_values) const {
+    return HexMapCellId::to_packed_vecs(
+            compute_fov(origin, radius, to_value_set(opaque_values)));
+}
+
+namespace {
+// state shared by the compute_fov_batch() worker tasks; each task only
+// writes its own entry in `results`.
+struct FovBatch {
+    const HexMapNode *node;
+    const Vector3 *origins;
+    int radius;
+    HashSet<int> opaque_values;
+    LocalVector<PackedVector3Array> results;
+
+    static void run(void *userdata, uint32_t index) {
+        FovBatch *batch = static_cast<FovBatch *>(userdata);
+        Vector<HexMapCellId> cells = batch->node->compute_fov(
+                Vector3i(batch->origins[index]),
+                batch->radius,
+                batch->opaque_values);
+        batch->results[index] = HexMapCellId::to_packed_vecs(cells);
+    }
+};
+} // namespace
+
+Array HexMapNode::compute_fov_batch(const PackedVector3Array &origins,
+        int radius,
+        const PackedInt32Array &opaque_values) const {
+    auto profiler = profiling_begin("HexMapNode::compute_fov_batch()");
+
+    Array out;
+    ERR_FAIL_COND_V_MSG(radius < 0, out, "radius must not be negative");
+    if (origins.is_empty()) {
+        return out;
+    }
+
+    FovBatch batch{
+        .node = this,
+        .origins = origins.ptr(),
+        .radius = radius,
+        .opaque_values = to_value_set(opaque_values),
+    };
+    batch.results.resize(origins.size());
+
+    // the cell maps are only read, so the tasks can share them as long as
+    // the main thread waits here
+    WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+    int64_t group_id = pool->add_native_group_task(&FovBatch::run,
+            &batch,
+            origins.size(),
+            -1,
+            true,
+            "HexMapNode::compute_fov_batch");
+    pool->wait_for_group_task_completion(group_id);
+
+    out.resize(origins.size());
+    for (int i = 0; i < origins.size(); i++) {
+        out[i] = batch.results[i];
+    }
+    return out;
+}
+
+PackedVector3Array HexMapNode::get_occupied_neighbor_vecs(Vector3i cell_vec,
+        int radius,
+        bool include_self) const {
+    PackedVector3Array out;
+    ERR_FAIL_COND_V_MSG(radius < 0, out, "radius must not be negative");
+    HexMapCellId center = cell_vec;
+    for (const HexMapCellId &cell :
+            center.get_neighbors(radius, HexMapPlanes::All, include_self)) {
+        if (has(cell)) {
+            out.push_back(Vector3(cell.to_vec()));
+        }
+    }
+    return out;
+}
+
+PackedVector3Array HexMapNode::get_occupied_ring_vecs(Vector3i cell_vec,
+        int radius) const {
+    PackedVector3Array out;
+    ERR_FAIL_COND_V_MSG(radius < 0, out, "radius must not be negative");
+    LocalVector<HexMapCellId> ring;
+    HexMapCellId(cell_vec).get_ring(radius, ring);
+    for (const HexMapCellId &cell : ring) {
+        if (has(cell)) {
+            out.push_back(Vector3(cell.to_vec()));
+        }
+    }
+    return out;
+}
+
+Ref<HexMapSnapshot> HexMapNode::get_snapshot() {
+    if (snapshot.is_null()) {
+        auto profiler = profiling_begin("HexMapNode::get_snapshot()");
+        Ref<HexMapSnapshot> copy;
+        copy.instantiate();
+        snapshot_cells(copy->cells);
+        snapshot = copy;
+    }
+    return snapshot;
+}
+
+void HexMapNode::cells_modified() {
+    snapshot.unref();
+    cells_version++;
+}
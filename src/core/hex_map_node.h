@@ -12,22 +12,37 @@
 #include <godot_cpp/core/defs.hpp>
 #include <godot_cpp/templates/hash_map.hpp>
 #include <godot_cpp/templates/hash_set.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
 #include <godot_cpp/templates/vector.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+#include <godot_cpp/variant/packed_vector3_array.hpp>
 #include <godot_cpp/variant/transform3d.hpp>
 #include <godot_cpp/variant/vector3i.hpp>
 
 #include "cell_id.h"
+#include "cell_map.h"
 #include "core/tile_orientation.h"
 #include "space.h"
 
 using namespace godot;
 
+class HexMapSnapshot;
+
 class HexMapNode : public Node3D {
     GDCLASS(HexMapNode, Node3D);
 
 protected:
     HexMapSpace space;
 
+    bool is_cell_opaque(const HexMapCellId &,
+            const HashSet<int> &opaque_values) const;
+
+    /// has_line_of_sight() with a caller supplied buffer for the line
+    bool has_line_of_sight(const HexMapCellId &a,
+            const HexMapCellId &b,
+            const HashSet<int> &opaque_values,
+            LocalVector<HexMapCellId> &line) const;
+
     static void _bind_methods();
     void _notification(int p_what);
 
@@ -61,6 +76,8 @@ public:
         CELL_ARRAY_WIDTH,
     };
 
+    ~HexMapNode();
+
     // various cell size getters/setters
     void set_cell_height(real_t p_height);
     real_t get_cell_height() const;
@@ -78,6 +95,13 @@ public:
     /// called when the cell scale changes
     virtual bool on_hex_space_changed();
 
+    /// called when only the global transform of the hex space changes
+    ///
+    /// Subclasses should override this to reposition any existing instances
+    /// without rebuilding them.  The default implementation emits the
+    /// `hex_space_changed` signal.
+    virtual void on_hex_space_transform_changed();
+
     /// given a cell id, return the local position of the cell
     Vector3 get_cell_center(const HexMapCellId &) const;
     Vector3 get_cell_center(const Ref<hex_bind::HexMapCellId>) const;
@@ -86,6 +110,22 @@ public:
     HexMapCellId get_cell_id(Vector3) const;
     Ref<hex_bind::HexMapCellId> _get_cell_id(Vector3) const;
 
+    /// Batch version of get_cell_id(); return the cell vector of the cell
+    /// containing each local point.
+    PackedVector3Array points_to_cell_vecs(
+            const PackedVector3Array &local_points) const;
+
+    /// Batch version of get_cell_id(); return the cell key of the cell
+    /// containing each local point.  Returns an empty array if any point is
+    /// beyond the 16-bit range of a key.  @see HexMapCellId.vecs_to_keys()
+    PackedInt64Array points_to_cell_keys(
+            const PackedVector3Array &local_points) const;
+
+    /// Batch version of get_cell_center(); return the local center of each
+    /// cell vector.
+    PackedVector3Array cell_vecs_to_centers(
+            const PackedVector3Array &cell_vecs) const;
+
     /// set a single cell
     virtual void set_cell(const HexMapCellId &,
             int tile,
@@ -131,6 +171,13 @@ public:
     /// @return Array array of Vector3i encoded cell IDs
     virtual Array find_cell_vecs_by_value(int value) const = 0;
 
+    /// estimate the memory used by this node
+    ///
+    /// @return Dictionary of category name to bytes used, including a
+    ///     `total` entry.  Bytes are estimated from container capacities;
+    ///     allocator overhead is not included.
+    virtual Dictionary get_memory_usage() const = 0;
+
     /// set the visibility of a cell
     ///
     /// This is used by HexMapEditorPlugin to show/hide cells that overlap the
@@ -144,6 +191,72 @@ public:
     /// visibility state of the cell with id Vector3.
     void set_cells_visibility(const Array cells);
 
+    /// cell found by raycast_cells()
+    struct RaycastHit {
+        HexMapCellId cell_id;
+        CellInfo info;
+        /// local point where the ray entered the cell
+        Vector3 point;
+        /// outward normal of the cell face the ray entered through; zero if
+        /// the ray started inside the cell
+        Vector3 normal;
+    };
+
+    /// walk the cells along a line segment in local space, and return the
+    /// first `max_hits` cells that have a value, nearest first.
+    ///
+    /// This reads the cell map directly, so it does not depend on any
+    /// physics bodies being built.
+    Vector<RaycastHit> raycast_cells(Vector3 from,
+            Vector3 to,
+            int max_hits = 1) const;
+
+    /// gdscript wrapper for raycast_cells(); returns an Array of Dictionary
+    /// with keys `cell_id` (Vector3i), `value`, `orientation`, `point`, and
+    /// `normal`.
+    Array _raycast_cells(Vector3 from, Vector3 to, int max_hits = 1) const;
+
+    /// return the occupied cells within `radius` of `cell`, as Vector3i
+    /// cell ids; filtering happens here rather than in gdscript.
+    PackedVector3Array get_occupied_neighbor_vecs(Vector3i cell,
+            int radius = 1,
+            bool include_self = false) const;
+
+    /// return the occupied cells exactly `radius` from `cell` in the same
+    /// layer, as Vector3i cell ids
+    PackedVector3Array get_occupied_ring_vecs(Vector3i cell,
+            int radius) const;
+
+    /// check if any cell between `a` and `b` blocks the line of sight
+    ///
+    /// Only the cells strictly between `a` and `b` are checked.  A cell
+    /// blocks the line when its value is in `opaque_values`, or when it has
+    /// any value if `opaque_values` is empty.
+    bool has_line_of_sight(const HexMapCellId &a,
+            const HexMapCellId &b,
+            const HashSet<int> &opaque_values) const;
+    bool _has_line_of_sight(Vector3i a,
+            Vector3i b,
+            const PackedInt32Array &opaque_values) const;
+
+    /// return every cell within `radius` of `origin` that has line of sight
+    /// to `origin`; opaque cells that are seen are included.
+    Vector<HexMapCellId> compute_fov(const HexMapCellId &origin,
+            int radius,
+            const HashSet<int> &opaque_values) const;
+    PackedVector3Array _compute_fov(Vector3i origin,
+            int radius,
+            const PackedInt32Array &opaque_values) const;
+
+    /// compute_fov() for many origins, in parallel on the WorkerThreadPool
+    ///
+    /// The cells must not be modified until this returns.
+    ///
+    /// @returns Array of PackedVector3Array, one per origin
+    Array compute_fov_batch(const PackedVector3Array &origins,
+            int radius,
+            const PackedInt32Array &opaque_values) const;
+
     /// return the `HexMapCellId` of every cell within a quad in local space
     /// @see HexSpace.get_cell_ids_in_local_quad()
     Array get_cell_ids_in_local_quad(Vector3 a,
@@ -151,4 +264,28 @@ public:
             Vector3 c,
             Vector3 d,
             float padding = 0.5) const;
+
+    /// return a read-only copy of the cells that can be read from any thread
+    ///
+    /// Call this from the main thread, then hand the snapshot to worker
+    /// threads.  The same snapshot is returned until a cell is modified, so
+    /// taking one every frame only costs a copy when the map has changed.
+    Ref<HexMapSnapshot> get_snapshot();
+
+    /// incremented every time a cell is modified; lets callers that cache
+    /// per-cell data detect changes made without the `cells_changed` signal
+    inline uint64_t get_cells_version() const { return cells_version; }
+
+protected:
+    /// copy every cell into `cells` for get_snapshot()
+    virtual void snapshot_cells(HexMapCellMap<CellInfo> &cells) const = 0;
+
+    /// subclasses must call this whenever a cell is added, removed, or has
+    /// its value or orientation changed
+    void cells_modified();
+
+private:
+    /// returned by get_snapshot() until the cells are modified
+    Ref<HexMapSnapshot> snapshot;
+    uint64_t cells_version = 0;
 };
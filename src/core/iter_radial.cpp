@@ -17,18 +17,30 @@ HexMapIterRadial::HexMapIterRadial(const HexMapCellId center,
         const HexMapPlanes &planes) :
         axial_iter(center, radius, planes),
         radius(radius),
-        exclude_center(exclude_center) {
-    advance_until_valid();
+        exclude_center(exclude_center),
+        planar(!planes.y && planes.q && planes.r && planes.s) {
+    if (planar) {
+        spiral_iter = HexMapIterSpiral(center, radius, exclude_center);
+    } else {
+        advance_until_valid();
+    }
 }
 
 // prefix increment
 HexMapIterRadial &HexMapIterRadial::operator++() {
+    if (planar) {
+        ++spiral_iter;
+        return *this;
+    }
     ++axial_iter;
     advance_until_valid();
     return *this;
 }
 
 HexMapIterRadial HexMapIterRadial::begin() {
+    if (planar) {
+        return HexMapIterRadial(spiral_iter.begin(), radius);
+    }
     HexMapIterRadial iter(axial_iter.begin(), radius, exclude_center);
     iter.advance_until_valid();
     return iter;
@@ -37,10 +49,15 @@ HexMapIterRadial HexMapIterRadial::begin() {
 HexMapIterRadial HexMapIterRadial::end() {
     HexMapIterRadial iter = *this;
     iter.axial_iter = axial_iter.end();
+    iter.spiral_iter = spiral_iter.end();
     return iter;
 }
 
 HexMapIterRadial::operator String() const {
+    if (planar) {
+        return (String)"{ .spiral_iter = " + spiral_iter.operator String() +
+                " }";
+    }
     // clang-format off
     return (String)"{ " +
         ".center = " + axial_iter.center.operator String() + ", " +
@@ -60,7 +77,7 @@ HexMapIterRadial::operator String() const {
 
 bool HexMapIterRadial::_iter_init() {
     *this = begin();
-    return axial_iter.cell != HexMapCellId::INVALID;
+    return **this != HexMapCellId::INVALID;
 }
 
 bool HexMapIterRadial::_iter_next() {
@@ -68,7 +85,7 @@ bool HexMapIterRadial::_iter_next() {
     return cell != HexMapCellId::INVALID;
 }
 
-HexMapCellId HexMapIterRadial::_iter_get() const { return axial_iter.cell; }
+HexMapCellId HexMapIterRadial::_iter_get() const { return **this; }
 
 HexMapIter *HexMapIterRadial::clone() const {
     return new HexMapIterRadial(*this);
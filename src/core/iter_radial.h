@@ -7,8 +7,13 @@
 #include "cell_id.h"
 #include "iter.h"
 #include "iter_axial.h"
+#include "iter_spiral.h"
 
 // HexMap cell iterator using axial coordinates to define a volume to iterate
+//
+// When the planes limit the iterator to the center layer, the cells are
+// generated exactly by a HexMapIterSpiral instead of filtering the axial
+// bounding box.
 struct HexMapIterRadial : public HexMapIter {
 public:
     HexMapIterRadial(const HexMapCellId center,
@@ -21,19 +26,26 @@ public:
             axial_iter(iter),
             radius(radius),
             exclude_center(exclude_center) {};
+    HexMapIterRadial(HexMapIterSpiral iter, unsigned int radius) :
+            axial_iter(HexMapCellId(), 0),
+            radius(radius),
+            exclude_center(false),
+            planar(true),
+            spiral_iter(iter) {};
     HexMapIterRadial(const HexMapIterRadial &) = default;
 
     friend bool operator==(const HexMapIterRadial &a,
             const HexMapIterRadial &b) {
-        return a.axial_iter == b.axial_iter;
+        return *a == *b;
     };
     friend bool operator!=(const HexMapIterRadial &a,
             const HexMapIterRadial &b) {
-        return a.axial_iter != b.axial_iter;
+        return *a != *b;
     };
 
-    HexMapCellId operator*() const { return axial_iter.cell; }
-    const HexMapCellId &operator->() { return axial_iter.cell; }
+    HexMapCellId operator*() const {
+        return planar ? *spiral_iter : axial_iter.cell;
+    }
     HexMapIterRadial &operator++();
     HexMapIterRadial begin();
     HexMapIterRadial end();
@@ -55,4 +67,8 @@ private:
     HexMapIterAxial axial_iter;
     unsigned int radius;
     bool exclude_center;
+
+    // only iterating the center layer; use spiral_iter instead of axial_iter
+    bool planar = false;
+    HexMapIterSpiral spiral_iter;
 };
@@ -0,0 +1,75 @@
+#include "iter_ring.h"
+#include "cell_id.h"
+
+// the ring starts at the southwest corner, and walks each side in turn
+// https://www.redblobgames.com/grids/hexagons/#rings
+static constexpr int RING_START_DIRECTION = 4;
+
+HexMapIterRing::HexMapIterRing(const HexMapCellId center,
+        unsigned int radius) :
+        center(center), radius(radius) {
+    *this = begin();
+}
+
+// prefix increment
+HexMapIterRing &HexMapIterRing::operator++() {
+    if (cell == HexMapCellId::INVALID) {
+        return *this;
+    }
+
+    // radius zero ring is only the center cell
+    if (radius == 0) {
+        cell = HexMapCellId::INVALID;
+        return *this;
+    }
+
+    cell = cell + HexMapCellId::DIRECTIONS[side];
+    if (++step == radius) {
+        step = 0;
+        if (++side == 6) {
+            cell = HexMapCellId::INVALID;
+        }
+    }
+    return *this;
+}
+
+HexMapIterRing HexMapIterRing::begin() {
+    HexMapIterRing iter = *this;
+    iter.cell = center +
+            HexMapCellId::DIRECTIONS[RING_START_DIRECTION] * (int)radius;
+    iter.side = 0;
+    iter.step = 0;
+    return iter;
+}
+
+HexMapIterRing HexMapIterRing::end() {
+    HexMapIterRing iter = *this;
+    iter.cell = HexMapCellId::INVALID;
+    return iter;
+}
+
+HexMapIterRing::operator String() const {
+    // clang-format off
+    return (String)"{ " +
+        ".center = " + center.operator String() + ", " +
+        ".radius = " + itos(radius) + ", " +
+        ".cell = " + cell.operator String() + ", " +
+        ".side = " + itos(side) + ", " +
+        ".step = " + itos(step) + ", " +
+    "}";
+    // clang-format on
+}
+
+bool HexMapIterRing::_iter_init() {
+    *this = begin();
+    return cell != HexMapCellId::INVALID;
+}
+
+bool HexMapIterRing::_iter_next() {
+    HexMapCellId cell = *operator++();
+    return cell != HexMapCellId::INVALID;
+}
+
+HexMapCellId HexMapIterRing::_iter_get() const { return cell; }
+
+HexMapIter *HexMapIterRing::clone() const { return new HexMapIterRing(*this); }
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/classes/wrapped.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include "cell_id.h"
+#include "iter.h"
+
+// HexMap cell iterator for the cells exactly `radius` from the center, in the
+// same layer as the center.  The cells are generated by walking the six sides
+// of the ring, so no candidate cells are rejected.
+struct HexMapIterRing : public HexMapIter {
+public:
+    HexMapIterRing(const HexMapCellId center = HexMapCellId(),
+            unsigned int radius = 0);
+    HexMapIterRing(const HexMapIterRing &) = default;
+
+    friend bool operator==(const HexMapIterRing &a, const HexMapIterRing &b) {
+        return a.cell == b.cell;
+    };
+    friend bool operator!=(const HexMapIterRing &a, const HexMapIterRing &b) {
+        return a.cell != b.cell;
+    };
+
+    HexMapCellId operator*() const { return cell; }
+    const HexMapCellId &operator->() { return cell; }
+    HexMapIterRing &operator++();
+    HexMapIterRing begin();
+    HexMapIterRing end();
+
+    // gdscript integration methods
+    operator godot::String() const;
+    bool _iter_init();
+    bool _iter_next();
+    HexMapCellId _iter_get() const;
+    HexMapIter *clone() const;
+
+    // for doctests
+    friend std::ostream &operator<<(std::ostream &os,
+            const HexMapIterRing &value);
+
+private:
+    HexMapCellId center, cell;
+    unsigned int radius;
+
+    // index into HexMapCellId::DIRECTIONS of the side being walked, and the
+    // number of steps taken along that side
+    unsigned int side = 0;
+    unsigned int step = 0;
+};
@@ -0,0 +1,66 @@
+#include "iter_spiral.h"
+#include "cell_id.h"
+
+HexMapIterSpiral::HexMapIterSpiral(const HexMapCellId center,
+        unsigned int radius,
+        bool exclude_center) :
+        center(center), radius(radius), exclude_center(exclude_center) {
+    *this = begin();
+}
+
+// prefix increment
+HexMapIterSpiral &HexMapIterSpiral::operator++() {
+    if (*ring == HexMapCellId::INVALID) {
+        return *this;
+    }
+
+    ++ring;
+    if (*ring == HexMapCellId::INVALID && ring_radius < radius) {
+        ring_radius++;
+        ring = HexMapIterRing(center, ring_radius);
+    }
+    return *this;
+}
+
+HexMapIterSpiral HexMapIterSpiral::begin() {
+    HexMapIterSpiral iter = *this;
+    iter.ring_radius = 0;
+    iter.ring = HexMapIterRing(center, 0);
+    if (exclude_center) {
+        ++iter;
+    }
+    return iter;
+}
+
+HexMapIterSpiral HexMapIterSpiral::end() {
+    HexMapIterSpiral iter = *this;
+    iter.ring = iter.ring.end();
+    return iter;
+}
+
+HexMapIterSpiral::operator String() const {
+    // clang-format off
+    return (String)"{ " +
+        ".center = " + center.operator String() + ", " +
+        ".radius = " + itos(radius) + ", " +
+        ".exclude_center = " + (exclude_center ? "true" : "false") + ", " +
+        ".ring = " + ring.operator String() + ", " +
+    "}";
+    // clang-format on
+}
+
+bool HexMapIterSpiral::_iter_init() {
+    *this = begin();
+    return *ring != HexMapCellId::INVALID;
+}
+
+bool HexMapIterSpiral::_iter_next() {
+    HexMapCellId cell = *operator++();
+    return cell != HexMapCellId::INVALID;
+}
+
+HexMapCellId HexMapIterSpiral::_iter_get() const { return *ring; }
+
+HexMapIter *HexMapIterSpiral::clone() const {
+    return new HexMapIterSpiral(*this);
+}
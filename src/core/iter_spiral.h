@@ -0,0 +1,54 @@
+#pragma once
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/classes/wrapped.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include "cell_id.h"
+#include "iter.h"
+#include "iter_ring.h"
+
+// HexMap cell iterator for every cell within `radius` of the center, in the
+// same layer as the center.  Cells are returned ring by ring, starting at the
+// center, so they are ordered by distance from the center.
+struct HexMapIterSpiral : public HexMapIter {
+public:
+    HexMapIterSpiral(const HexMapCellId center = HexMapCellId(),
+            unsigned int radius = 0,
+            bool exclude_center = false);
+    HexMapIterSpiral(const HexMapIterSpiral &) = default;
+
+    friend bool operator==(const HexMapIterSpiral &a,
+            const HexMapIterSpiral &b) {
+        return *a.ring == *b.ring;
+    };
+    friend bool operator!=(const HexMapIterSpiral &a,
+            const HexMapIterSpiral &b) {
+        return *a.ring != *b.ring;
+    };
+
+    HexMapCellId operator*() const { return *ring; }
+    HexMapIterSpiral &operator++();
+    HexMapIterSpiral begin();
+    HexMapIterSpiral end();
+
+    // gdscript integration methods
+    operator godot::String() const;
+    bool _iter_init();
+    bool _iter_next();
+    HexMapCellId _iter_get() const;
+    HexMapIter *clone() const;
+
+    // for doctests
+    friend std::ostream &operator<<(std::ostream &os,
+            const HexMapIterSpiral &value);
+
+private:
+    HexMapCellId center;
+    unsigned int radius;
+    bool exclude_center;
+
+    // current ring, and its radius
+    HexMapIterRing ring;
+    unsigned int ring_radius = 0;
+};
@@ -0,0 +1,161 @@
+#include <godot_cpp/classes/array_mesh.hpp>
+#include <godot_cpp/classes/navigation_mesh.hpp>
+#include <godot_cpp/core/error_macros.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+
+#include "library_cache.h"
+#include "profiling.h"
+
+HashMap<uint64_t, HexMapLibraryCache *> HexMapLibraryCache::caches;
+
+Ref<HexMapLibraryCache> HexMapLibraryCache::get(
+        const Ref<MeshLibrary> &library) {
+    if (!library.is_valid()) {
+        return Ref<HexMapLibraryCache>();
+    }
+
+    uint64_t library_id = library->get_instance_id();
+    HexMapLibraryCache **existing = caches.getptr(library_id);
+    if (existing != nullptr) {
+        return Ref<HexMapLibraryCache>(*existing);
+    }
+
+    Ref<HexMapLibraryCache> cache;
+    cache.instantiate();
+    cache->library = library;
+    library->connect("changed",
+            callable_mp(cache.ptr(), &HexMapLibraryCache::on_library_changed));
+    caches.insert(library_id, cache.ptr());
+    return cache;
+}
+
+HexMapLibraryCache::~HexMapLibraryCache() {
+    clear_shape_debug_vertices();
+    if (!library.is_valid()) {
+        return;
+    }
+    caches.erase(library->get_instance_id());
+    library->disconnect("changed",
+            callable_mp(this, &HexMapLibraryCache::on_library_changed));
+}
+
+void HexMapLibraryCache::invalidate() {
+    dirty = true;
+    version++;
+}
+
+void HexMapLibraryCache::on_library_changed() { invalidate(); }
+
+void HexMapLibraryCache::clear_shape_debug_vertices() {
+    Callable on_changed =
+            callable_mp(this, &HexMapLibraryCache::on_shape_changed);
+    for (const auto &iter : shape_debug_vertices) {
+        const Ref<Shape3D> &shape = iter.value.shape;
+        if (shape.is_valid() && shape->is_connected("changed", on_changed)) {
+            shape->disconnect("changed", on_changed);
+        }
+    }
+    shape_debug_vertices.clear();
+}
+
+// Editing a shape (radius, size, points) changes its debug mesh without the
+// MeshLibrary emitting `changed`.  This is rare enough that we drop the
+// vertices for every shape rather than tracking which one changed.
+void HexMapLibraryCache::on_shape_changed() { clear_shape_debug_vertices(); }
+
+void HexMapLibraryCache::rebuild() {
+    auto profiler = profiling_begin("HexMapLibraryCache::rebuild()");
+
+    dirty = false;
+    items.clear();
+    clear_shape_debug_vertices();
+
+    ERR_FAIL_COND(!library.is_valid());
+
+    const PackedInt32Array ids = library->get_item_list();
+    int32_t max_id = -1;
+    for (int32_t id : ids) {
+        // cells store the item id in 16 bits, so anything larger can never
+        // be looked up
+        if (id <= UINT16_MAX && id > max_id) {
+            max_id = id;
+        }
+    }
+    items.resize(max_id + 1);
+
+    for (int32_t id : ids) {
+        if (id < 0 || id > max_id) {
+            continue;
+        }
+        Item &item = items[id];
+        item.exists = true;
+        item.mesh = library->get_item_mesh(id);
+        item.mesh_transform = library->get_item_mesh_transform(id);
+        if (item.mesh.is_valid()) {
+            item.mesh_rid = item.mesh->get_rid();
+            item.aabb = item.mesh_transform.xform(item.mesh->get_aabb());
+        }
+
+        Ref<NavigationMesh> navmesh = library->get_item_navigation_mesh(id);
+        item.has_navigation_mesh = navmesh.is_valid();
+        if (navmesh.is_valid()) {
+            item.navigation_mesh_transform =
+                    library->get_item_navigation_mesh_transform(id);
+            item.navigation_vertices = navmesh->get_vertices();
+
+            // fan-triangulate the convex navigation mesh polygons
+            int vertex_count = item.navigation_vertices.size();
+            for (int p = 0; p < navmesh->get_polygon_count(); p++) {
+                const PackedInt32Array polygon = navmesh->get_polygon(p);
+                for (int i = 1; i + 1 < polygon.size(); i++) {
+                    ERR_CONTINUE(polygon[0] >= vertex_count ||
+                            polygon[i] >= vertex_count ||
+                            polygon[i + 1] >= vertex_count);
+                    item.navigation_indices.push_back(polygon[0]);
+                    item.navigation_indices.push_back(polygon[i]);
+                    item.navigation_indices.push_back(polygon[i + 1]);
+                }
+            }
+        }
+
+        // get_item_shapes() returns an array of Shape3D followed by
+        // Transform3D for each shape.
+        const Array shapes = library->get_item_shapes(id);
+        item.shapes.reserve(shapes.size() / 2);
+        for (int i = 0; i + 1 < shapes.size(); i += 2) {
+            Ref<Shape3D> shape = shapes[i];
+            ERR_CONTINUE_MSG(!shape.is_valid(), "invalid shape in MeshLibrary");
+            item.shapes.push_back(Shape{
+                    .shape = shape,
+                    .rid = shape->get_rid(),
+                    .transform = shapes[i + 1],
+            });
+        }
+    }
+}
+
+const PackedVector3Array &HexMapLibraryCache::get_shape_debug_vertices(
+        const Shape &shape) {
+    const ShapeDebug *cached = shape_debug_vertices.getptr(shape.rid);
+    if (cached != nullptr) {
+        return cached->vertices;
+    }
+
+    PackedVector3Array vertices;
+    const Ref<ArrayMesh> debug_mesh = shape.shape->get_debug_mesh();
+    if (debug_mesh.is_valid() && debug_mesh->get_surface_count() > 0) {
+        const Array arrays = debug_mesh->surface_get_arrays(0);
+        if (arrays.size() > Mesh::ARRAY_VERTEX) {
+            vertices = arrays[Mesh::ARRAY_VERTEX];
+        } else {
+            ERR_PRINT("shape debug mesh has no vertex array");
+        }
+    }
+    shape.shape->connect("changed",
+            callable_mp(this, &HexMapLibraryCache::on_shape_changed));
+    return shape_debug_vertices
+            .insert(shape.rid,
+                    ShapeDebug{ .shape = shape.shape, .vertices = vertices })
+            ->value.vertices;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <godot_cpp/classes/mesh.hpp>
+#include <godot_cpp/classes/mesh_library.hpp>
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/classes/shape3d.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/aabb.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+#include <godot_cpp/variant/packed_vector3_array.hpp>
+#include <godot_cpp/variant/rid.hpp>
+#include <godot_cpp/variant/transform3d.hpp>
+
+using namespace godot;
+
+/// Flat per-item table of the `MeshLibrary` data used when building cells.
+///
+/// Every `MeshLibrary` getter goes through the engine API and allocates
+/// Variants, which adds up when called once per cell.  This class decodes
+/// each item once, and shares the result between every user of the same
+/// `MeshLibrary`.  The table is rebuilt lazily after the `MeshLibrary` emits
+/// `changed`.
+///
+/// Main thread only.
+class HexMapLibraryCache : public RefCounted {
+    GDCLASS(HexMapLibraryCache, RefCounted)
+
+public:
+    /// collision shape for an item
+    struct Shape {
+        Ref<Shape3D> shape;
+        RID rid;
+        /// shape transform relative to the cell
+        Transform3D transform;
+    };
+
+    /// cached data for a single `MeshLibrary` item
+    struct Item {
+        /// false if the item id does not exist in the `MeshLibrary`
+        bool exists = false;
+        Ref<Mesh> mesh;
+        /// invalid if the item has no mesh
+        RID mesh_rid;
+        Transform3D mesh_transform;
+        LocalVector<Shape> shapes;
+        bool has_navigation_mesh = false;
+        /// navigation mesh polygons triangulated into an indexed triangle
+        /// list, and the navigation mesh transform relative to the cell
+        PackedVector3Array navigation_vertices;
+        PackedInt32Array navigation_indices;
+        Transform3D navigation_mesh_transform;
+        /// mesh AABB with `mesh_transform` applied
+        AABB aabb;
+    };
+
+    /// get the shared cache for a `MeshLibrary`; returns a null `Ref` if
+    /// `library` is null.
+    static Ref<HexMapLibraryCache> get(const Ref<MeshLibrary> &library);
+
+    /// get the cached data for an item, or nullptr if the item does not
+    /// exist in the `MeshLibrary`.
+    inline const Item *get_item(int id) {
+        if (dirty) {
+            rebuild();
+        }
+        if (id < 0 || (uint32_t)id >= items.size() || !items[id].exists) {
+            return nullptr;
+        }
+        return &items[id];
+    }
+
+    /// get the vertices of the collision debug mesh for a shape; these are
+    /// only needed when debugging collisions, so they are fetched on first
+    /// use and cached by shape RID until the shape emits `changed`.
+    const PackedVector3Array &get_shape_debug_vertices(const Shape &shape);
+
+    /// discard all cached item data; the table will be rebuilt on next use
+    void invalidate();
+
+    /// incremented every time the cache is invalidated; used by consumers to
+    /// detect when they need to rebuild from the new item data.
+    inline uint32_t get_version() const { return version; }
+
+    inline Ref<MeshLibrary> get_library() const { return library; }
+
+    HexMapLibraryCache() {};
+    ~HexMapLibraryCache();
+
+protected:
+    static void _bind_methods() {};
+
+private:
+    void rebuild();
+    void on_library_changed();
+
+    /// debug vertices for a shape, and the shape so we can watch it for
+    /// changes
+    struct ShapeDebug {
+        Ref<Shape3D> shape;
+        PackedVector3Array vertices;
+    };
+
+    /// drop the cached debug vertices, and stop watching the shapes
+    void clear_shape_debug_vertices();
+    void on_shape_changed();
+
+    Ref<MeshLibrary> library;
+    LocalVector<Item> items;
+    HashMap<RID, ShapeDebug> shape_debug_vertices;
+    bool dirty = true;
+    uint32_t version = 0;
+
+    /// all live caches, by `MeshLibrary` instance id; entries are removed
+    /// when the cache is freed.
+    static HashMap<uint64_t, HexMapLibraryCache *> caches;
+};
@@ -17,6 +17,10 @@ void HexMapLibraryMeshTool::set_space(const HexMapSpace &value) {
 void HexMapLibraryMeshTool::set_mesh_library(Ref<MeshLibrary> &value) {
     if (value != mesh_library) {
         mesh_library = value;
+        library_cache = HexMapLibraryCache::get(value);
+        if (library_cache.is_valid()) {
+            library_cache_version = library_cache->get_version();
+        }
         rebuild = true;
     }
 }
@@ -25,29 +29,33 @@ void HexMapLibraryMeshTool::set_cell(HexMapCellId cell_id,
         int index,
         HexMapTileOrientation orientation) {
     Transform3D mesh_transform;
-    Ref<Mesh> mesh;
+    RID mesh;
 
     // try to get the mesh from the MeshLibrary
-    if (mesh_library.is_valid()) {
-        mesh = mesh_library->get_item_mesh(index);
-        mesh_transform = mesh_library->get_item_mesh_transform(index);
+    const HexMapLibraryCache::Item *item = nullptr;
+    if (library_cache.is_valid()) {
+        item = library_cache->get_item(index);
     }
-
-    // mesh not found in MeshLibrary; use placeholder
-    if (!mesh.is_valid()) {
-        mesh = get_placeholder_mesh();
+    if (item != nullptr && item->mesh_rid.is_valid()) {
+        mesh = item->mesh_rid;
+        mesh_transform = item->mesh_transform;
+    } else {
+        // mesh not found in MeshLibrary; use placeholder
+        mesh = get_placeholder_mesh()->get_rid();
         mesh_transform = Transform3D(Basis::from_scale(space.get_cell_scale()),
                 -get_mesh_origin() * space.get_cell_scale());
     }
 
     Transform3D cell_transform(orientation);
-    HexMapMeshTool::set_cell(
-            cell_id, mesh->get_rid(), cell_transform * mesh_transform);
+    HexMapMeshTool::set_cell(cell_id, mesh, cell_transform * mesh_transform);
 
+    const CellState *current = cell_map.getptr(cell_id);
+    bool occluded = current != nullptr && current->occluded;
     cell_map.insert(cell_id,
             CellState{
                     .index = index,
                     .orientation = orientation,
+                    .occluded = occluded,
             });
 }
 
@@ -56,20 +64,21 @@ void HexMapLibraryMeshTool::clear_cell(const HexMapCellId &cell_id) {
     cell_map.erase(cell_id);
 }
 
-Ref<ArrayMesh> HexMapLibraryMeshTool::get_placeholder_mesh() {
-    if (placeholder_mesh.is_valid()) {
-        return placeholder_mesh;
+bool HexMapLibraryMeshTool::set_cell_occluded(const HexMapCellId &cell_id,
+        bool occluded) {
+    CellState *state = cell_map.getptr(cell_id);
+    if (state == nullptr || state->occluded == occluded) {
+        return false;
     }
+    state->occluded = occluded;
+    HexMapMeshTool::set_cell_occluded(cell_id, occluded);
+    return true;
+}
 
-    Ref<StandardMaterial3D> surface_mat;
-    surface_mat.instantiate();
-    surface_mat->set_albedo(Color(1.7, 0.1, 0.1, 0.7));
-    surface_mat->set_shading_mode(StandardMaterial3D::SHADING_MODE_UNSHADED);
-    surface_mat->set_flag(StandardMaterial3D::FLAG_DISABLE_FOG, true);
-    surface_mat->set_transparency(StandardMaterial3D::TRANSPARENCY_ALPHA);
-
-    placeholder_mesh = space.build_cell_mesh();
-    placeholder_mesh->surface_set_material(0, surface_mat);
+Ref<ArrayMesh> HexMapLibraryMeshTool::get_placeholder_mesh() {
+    if (!placeholder_mesh.is_valid()) {
+        placeholder_mesh = space.build_placeholder_mesh();
+    }
     return placeholder_mesh;
 }
 
@@ -82,12 +91,22 @@ void HexMapLibraryMeshTool::refresh() {
     // - cell visibility changed: no
     // purpose: need to preserve MeshTool state for visibility to work
 
+    // MeshLibrary items were modified since we last built the meshes
+    if (library_cache.is_valid() &&
+            library_cache->get_version() != library_cache_version) {
+        library_cache_version = library_cache->get_version();
+        rebuild = true;
+    }
+
     if (rebuild) {
         auto prof = profiling_begin("HexMapLibraryMeshTool: rebuilding inner");
         rebuild = false;
-        HexMapMeshTool::clear();
 
-        if (!mesh_library.is_valid()) {
+        // The inner cells are overwritten rather than cleared; the
+        // HexMapMeshTool keeps the per-cell custom data across set_cell(),
+        // and it is not duplicated in our CellState.
+
+        if (!library_cache.is_valid()) {
             // if the MeshLibrary isn't set, use all placeholder meshes
 
             RID mesh = get_placeholder_mesh()->get_rid();
@@ -97,31 +116,35 @@ void HexMapLibraryMeshTool::refresh() {
 
             for (const auto &iter : cell_map) {
                 HexMapMeshTool::set_cell(iter.key, mesh, transform);
+                HexMapMeshTool::set_cell_occluded(
+                        iter.key, iter.value.occluded);
             }
         } else {
             // mesh_library is valid, use it to look up meshes
 
+            RID placeholder = get_placeholder_mesh()->get_rid();
+            Transform3D placeholder_transform =
+                    Transform3D(Basis::from_scale(space.get_cell_scale()),
+                            -get_mesh_origin());
+
             for (const auto &iter : cell_map) {
                 // get the mesh and any mesh transform
-                Transform3D mesh_transform;
-                Ref<Mesh> mesh = mesh_library->get_item_mesh(iter.value.index);
-                if (mesh.is_valid()) {
-                    mesh_transform = mesh_library->get_item_mesh_transform(
-                            iter.value.index);
-                } else {
-                    // mesh not found in MeshLibrary; use placeholder
-                    mesh = get_placeholder_mesh();
-                    mesh_transform = Transform3D(
-                            Basis::from_scale(space.get_cell_scale()),
-                            -get_mesh_origin());
+                const HexMapLibraryCache::Item *item =
+                        library_cache->get_item(iter.value.index);
+                RID mesh = placeholder;
+                Transform3D mesh_transform = placeholder_transform;
+                if (item != nullptr && item->mesh_rid.is_valid()) {
+                    mesh = item->mesh_rid;
+                    mesh_transform = item->mesh_transform;
                 }
 
                 // get the cell transform based on cell orientation
                 Transform3D cell_transform(iter.value.orientation);
 
-                HexMapMeshTool::set_cell(iter.key,
-                        mesh->get_rid(),
-                        cell_transform * mesh_transform);
+                HexMapMeshTool::set_cell(
+                        iter.key, mesh, cell_transform * mesh_transform);
+                HexMapMeshTool::set_cell_occluded(
+                        iter.key, iter.value.occluded);
             }
         }
     }
@@ -2,6 +2,7 @@
 #include <godot_cpp/classes/mesh_library.hpp>
 
 #include "cell_id.h"
+#include "library_cache.h"
 #include "mesh_tool.h"
 #include "tile_orientation.h"
 
@@ -18,6 +19,10 @@ public:
 
         /// Mesh orientation
         HexMapTileOrientation orientation;
+
+        /// cell is enclosed by its neighbors; see
+        /// `HexMapMeshTool::set_cell_occluded()`
+        bool occluded = false;
     };
 
     using CellMap = HashMap<HexMapCellId::Key, CellState>;
@@ -44,6 +49,12 @@ public:
     /// clear the mesh for `cell`
     void clear_cell(const HexMapCellId &cell_id);
 
+    /// mark a cell as hidden by the cells around it; preserved across
+    /// `set_cell()` calls and rebuilds.
+    ///
+    /// @return true if the occluded state of the cell changed
+    bool set_cell_occluded(const HexMapCellId &cell_id, bool occluded);
+
     /// Get the list of cells & mesh details
     inline const CellMap &get_cells() const { return cell_map; };
 
@@ -59,6 +70,9 @@ private:
     Ref<ArrayMesh> get_placeholder_mesh();
 
     Ref<MeshLibrary> mesh_library;
+    Ref<HexMapLibraryCache> library_cache;
+    /// `library_cache` version the meshes were built from
+    uint32_t library_cache_version = 0;
     CellMap cell_map;
     Ref<ArrayMesh> placeholder_mesh;
 
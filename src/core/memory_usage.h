@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/hash_set.hpp>
+#include <godot_cpp/templates/vector.hpp>
+
+#include "cell_map.h"
+
+using namespace godot;
+
+// Estimates of the heap memory used by the godot containers, for
+// HexMapNode::get_memory_usage().  These count the buffers each container
+// allocates, but not allocator overhead, or memory owned by the values.
+
+/// HashMap allocates a bucket pointer and hash for every slot, plus one
+/// element (with list pointers) for each entry.
+template <typename K, typename V, typename H, typename C, typename A>
+size_t get_memory_usage(const HashMap<K, V, H, C, A> &map) {
+    if (map.is_empty()) {
+        return 0;
+    }
+    return map.get_capacity() *
+            (sizeof(HashMapElement<K, V> *) + sizeof(uint32_t)) +
+            map.size() * sizeof(HashMapElement<K, V>);
+}
+
+/// HashSet allocates the key, the hash, and two index arrays per slot.
+template <typename K, typename H, typename C>
+size_t get_memory_usage(const HashSet<K, H, C> &set) {
+    if (set.is_empty()) {
+        return 0;
+    }
+    return set.get_capacity() * (sizeof(K) + 3 * sizeof(uint32_t));
+}
+
+/// HexMapCellMap is a single allocation holding a control byte and an
+/// element for every slot.
+template <typename V>
+size_t get_memory_usage(const HexMapCellMap<V> &map) {
+    return map.get_allocated_size();
+}
+
+template <typename T>
+size_t get_memory_usage(const Vector<T> &vec) {
+    return vec.size() * sizeof(T);
+}
@@ -1,10 +1,26 @@
 #include <godot_cpp/classes/rendering_server.hpp>
 #include <godot_cpp/classes/standard_material3d.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
 
 #include "../profiling.h"
 #include "mesh_tool.h"
 
-void HexMapMeshTool::set_space(const HexMapSpace &value) { space = value; }
+SafeNumeric<int64_t> HexMapMeshTool::monitor_multimeshes;
+SafeNumeric<int64_t> HexMapMeshTool::monitor_instances;
+
+void HexMapMeshTool::set_space(const HexMapSpace &value) {
+    space = value;
+    set_transform(value.get_transform());
+}
+
+void HexMapMeshTool::set_transform(const Transform3D &value) {
+    space.set_transform(value);
+
+    RenderingServer *rs = RenderingServer::get_singleton();
+    for (const MultiMesh &mm : multimeshes) {
+        rs->instance_set_transform(mm.instance, value);
+    }
+}
 
 void HexMapMeshTool::set_mesh_origin(Vector3 value) { mesh_origin = value; }
 
@@ -14,72 +30,154 @@ void HexMapMeshTool::free_multimeshes() {
     for (const auto &multimesh : multimeshes) {
         rs->free_rid(multimesh.instance);
         rs->free_rid(multimesh.multimesh);
+        monitor_instances.sub(multimesh.instance_count);
     }
+    monitor_multimeshes.sub(multimeshes.size());
     multimeshes.clear();
 }
 
-// XXX maybe implement a performance oriented update that preserves multimesh
-// instances when possible.  Should be possible unless the cell_map changes.
-void HexMapMeshTool::build_multimeshes() {
-    ERR_FAIL_COND_MSG(!scenario.is_valid(),
-            "HexMapMeshManager instances does not have a valid scenario");
-
-    auto profiler = profiling_begin("HexMapMeshManager::build_multimeshes()");
+// write a cell transform into a multimesh buffer in the layout expected by
+// RenderingServer.multimesh_set_buffer()
+static inline void write_buffer_transform(float *out, const Transform3D &t) {
+    out[0] = t.basis.rows[0].x;
+    out[1] = t.basis.rows[0].y;
+    out[2] = t.basis.rows[0].z;
+    out[3] = t.origin.x;
+    out[4] = t.basis.rows[1].x;
+    out[5] = t.basis.rows[1].y;
+    out[6] = t.basis.rows[1].z;
+    out[7] = t.origin.y;
+    out[8] = t.basis.rows[2].x;
+    out[9] = t.basis.rows[2].y;
+    out[10] = t.basis.rows[2].z;
+    out[11] = t.origin.z;
+}
 
-    // to create the multimesh for cells, we need the mesh RID and the
-    // transform for each instance of that cell in the octant
-    HashMap<RID, Vector<Transform3D>> mesh_cells;
+static inline void write_buffer_color(float *out, const Color &color) {
+    out[0] = color.r;
+    out[1] = color.g;
+    out[2] = color.b;
+    out[3] = color.a;
+}
 
-    // calculate the mesh origin offset for each cell; this allows us to put
-    // the origin at the bottom or top of the cell, instead of the center.
-    Vector3 mesh_origin_offset = mesh_origin * space.get_cell_scale();
+// XXX maybe implement a performance oriented update that preserves multimesh
+// instances when possible.  Should be possible unless the instances change.
+void HexMapMeshTool::build_instances(const LocalVector<Instance> &instances,
+        LocalVector<InstanceSlot> &slots) {
+    free_multimeshes();
+    slots.resize(instances.size());
+    for (InstanceSlot &slot : slots) {
+        slot = InstanceSlot();
+    }
 
-    // iterate through the cells, save off RID & Transform pairs for multimesh
-    // creation later.
-    for (const auto &iter : cell_map) {
-        HexMapCellId cell_id(iter.key);
-        const Cell &cell = iter.value;
+    ERR_FAIL_COND_MSG(!scenario.is_valid(),
+            "HexMapMeshManager instances does not have a valid scenario");
 
-        // skip hidden cells
-        if (!cell.visible) {
-            continue;
-        }
+    auto profiler = profiling_begin("HexMapMeshManager::build_instances()");
 
-        Vector<Transform3D> *mesh_transforms = mesh_cells.getptr(cell.mesh);
-        if (mesh_transforms == nullptr) {
-            auto iter = mesh_cells.insert(cell.mesh, Vector<Transform3D>());
-            mesh_transforms = &iter->value;
+    // to create the multimesh for each mesh, we need the index of every
+    // instance that uses that mesh
+    HashMap<RID, LocalVector<uint32_t>> mesh_instances;
+    for (uint32_t i = 0; i < instances.size(); i++) {
+        auto *indices = mesh_instances.getptr(instances[i].mesh);
+        if (indices == nullptr) {
+            indices = &mesh_instances.insert(instances[i].mesh, {})->value;
         }
-
-        // get the transform for the mesh origin of the cell
-        Transform3D cell_origin_transform =
-                space.get_cell_transform_global(cell_id, mesh_origin_offset);
-        mesh_transforms->push_back(cell_origin_transform * cell.transform);
+        indices->push_back(i);
     }
 
     RenderingServer *rs = RenderingServer::get_singleton();
+    const int stride = get_buffer_stride();
+
+    // create a multimesh for each mesh
+    for (const auto &pair : mesh_instances) {
+        const LocalVector<uint32_t> &indices = pair.value;
+        int32_t multimesh_index = multimeshes.size();
+
+        // Fill out the multimesh buffer.  The instance transforms are in
+        // local space; the global transform is applied to the multimesh
+        // instance so that moving the node does not require us to rebuild
+        // the multimeshes.
+        PackedFloat32Array buffer;
+        buffer.resize(indices.size() * stride);
+        float *out = buffer.ptrw();
+        for (uint32_t i = 0; i < indices.size(); i++) {
+            const Instance &instance = instances[indices[i]];
+            slots[indices[i]] = InstanceSlot{
+                .multimesh = multimesh_index,
+                .instance = (int32_t)i,
+            };
+            write_buffer_transform(out + i * stride, instance.transform);
+            if (custom_data_format != CUSTOM_DATA_NONE) {
+                write_buffer_color(
+                        out + i * stride + 12, instance.custom_data);
+            }
+        }
 
-    // create a multimesh for each tile type present in the octant
-    for (const auto &pair : mesh_cells) {
         // create the multimesh
         RID multimesh = rs->multimesh_create();
         rs->multimesh_set_mesh(multimesh, pair.key);
         rs->multimesh_allocate_data(multimesh,
-                pair.value.size(),
-                RenderingServer::MULTIMESH_TRANSFORM_3D);
-
-        // copy all the transforms into it
-        const Vector<Transform3D> &transforms = pair.value;
-        for (int i = 0; i < transforms.size(); i++) {
-            rs->multimesh_instance_set_transform(multimesh, i, transforms[i]);
-        }
+                indices.size(),
+                RenderingServer::MULTIMESH_TRANSFORM_3D,
+                custom_data_format == CUSTOM_DATA_COLOR,
+                custom_data_format == CUSTOM_DATA_CUSTOM);
+        rs->multimesh_set_buffer(multimesh, buffer);
 
         // create an instance of the multimesh
         RID instance = rs->instance_create2(multimesh, scenario);
         rs->instance_attach_object_instance_id(instance, object_id);
+        rs->instance_set_transform(instance, space.get_transform());
         rs->instance_set_visible(instance, visible);
+        rs->instance_geometry_set_visibility_range(instance,
+                visibility_range_begin,
+                visibility_range_end,
+                0,
+                0,
+                RenderingServer::VISIBILITY_RANGE_FADE_DISABLED);
+
+        // only hang onto the buffer if we may need to patch it later
+        if (custom_data_format == CUSTOM_DATA_NONE) {
+            buffer = PackedFloat32Array();
+        }
+        multimeshes.push_back(MultiMesh{
+                multimesh, instance, buffer, (int64_t)indices.size() });
+        monitor_multimeshes.increment();
+        monitor_instances.add(indices.size());
+    }
+}
+
+void HexMapMeshTool::build_multimeshes() {
+    // calculate the mesh origin offset for each cell; this allows us to put
+    // the origin at the bottom or top of the cell, instead of the center.
+    Vector3 mesh_origin_offset = mesh_origin * space.get_cell_scale();
+
+    // build the instance list from the visible cells
+    LocalVector<Instance> instances;
+    LocalVector<Cell *> instance_cells;
+    for (auto &iter : cell_map) {
+        Cell &cell = iter.value;
+        cell.slot = InstanceSlot();
+
+        // skip hidden & occluded cells
+        if (!cell.visible || cell.occluded) {
+            continue;
+        }
+
+        Transform3D cell_origin_transform = space.get_cell_transform(
+                HexMapCellId(iter.key), mesh_origin_offset);
+        instances.push_back(Instance{
+                .mesh = cell.mesh,
+                .transform = cell_origin_transform * cell.transform,
+                .custom_data = cell.custom_data,
+        });
+        instance_cells.push_back(&cell);
+    }
 
-        multimeshes.push_back(MultiMesh{ multimesh, instance });
+    LocalVector<InstanceSlot> slots;
+    build_instances(instances, slots);
+    for (uint32_t i = 0; i < instance_cells.size(); i++) {
+        instance_cells[i]->slot = slots[i];
     }
 }
 
@@ -89,8 +187,98 @@ void HexMapMeshTool::set_cell(HexMapCellId cell_id,
     ERR_FAIL_COND_MSG(
             !mesh.is_valid(), "invalid mesh provided for cell " + cell_id);
 
-    cell_map.insert(
-            cell_id, Cell{ .mesh = mesh, .transform = mesh_transform });
+    const Cell *current = cell_map.getptr(cell_id);
+    bool occluded = current != nullptr && current->occluded;
+    Color custom_data =
+            current != nullptr ? current->custom_data : Color(1, 1, 1, 1);
+    cell_map.insert(cell_id,
+            Cell{
+                    .mesh = mesh,
+                    .transform = mesh_transform,
+                    .occluded = occluded,
+                    .custom_data = custom_data,
+            });
+}
+
+void HexMapMeshTool::set_instance_custom_data(InstanceSlot slot,
+        const Color &value) {
+    if (custom_data_format == CUSTOM_DATA_NONE || slot.multimesh < 0 ||
+            slot.multimesh >= multimeshes.size()) {
+        return;
+    }
+
+    // write the value directly into the instance slot
+    MultiMesh &mm = multimeshes.write[slot.multimesh];
+    int offset = slot.instance * get_buffer_stride() + 12;
+    write_buffer_color(mm.buffer.ptrw() + offset, value);
+
+    RenderingServer *rs = RenderingServer::get_singleton();
+    if (custom_data_format == CUSTOM_DATA_COLOR) {
+        rs->multimesh_instance_set_color(mm.multimesh, slot.instance, value);
+    } else {
+        rs->multimesh_instance_set_custom_data(
+                mm.multimesh, slot.instance, value);
+    }
+}
+
+void HexMapMeshTool::set_instances_custom_data(
+        const LocalVector<Pair<InstanceSlot, Color>> &instances) {
+    if (custom_data_format == CUSTOM_DATA_NONE) {
+        return;
+    }
+
+    // patch our copy of each multimesh buffer, and track which ones need to
+    // be uploaded
+    LocalVector<bool> modified;
+    modified.resize(multimeshes.size());
+    for (uint32_t i = 0; i < modified.size(); i++) {
+        modified[i] = false;
+    }
+
+    const int stride = get_buffer_stride();
+    for (const auto &pair : instances) {
+        const InstanceSlot &slot = pair.first;
+        if (slot.multimesh < 0 || slot.multimesh >= multimeshes.size()) {
+            continue;
+        }
+        MultiMesh &mm = multimeshes.write[slot.multimesh];
+        write_buffer_color(
+                mm.buffer.ptrw() + slot.instance * stride + 12, pair.second);
+        modified[slot.multimesh] = true;
+    }
+
+    RenderingServer *rs = RenderingServer::get_singleton();
+    for (uint32_t i = 0; i < modified.size(); i++) {
+        if (modified[i]) {
+            rs->multimesh_set_buffer(
+                    multimeshes[i].multimesh, multimeshes[i].buffer);
+        }
+    }
+}
+
+void HexMapMeshTool::set_cell_custom_data(HexMapCellId cell_id,
+        const Color &value) {
+    Cell *cell = cell_map.getptr(cell_id);
+    if (cell == nullptr) {
+        return;
+    }
+    cell->custom_data = value;
+    set_instance_custom_data(cell->slot, value);
+}
+
+void HexMapMeshTool::set_cells_custom_data(
+        const Vector<Pair<HexMapCellId::Key, Color>> &cells) {
+    LocalVector<Pair<InstanceSlot, Color>> instances;
+    instances.reserve(cells.size());
+    for (const auto &pair : cells) {
+        Cell *cell = cell_map.getptr(pair.first);
+        if (cell == nullptr) {
+            continue;
+        }
+        cell->custom_data = pair.second;
+        instances.push_back({ cell->slot, pair.second });
+    }
+    set_instances_custom_data(instances);
 }
 
 void HexMapMeshTool::clear_cell(HexMapCellId key) { cell_map.erase(key); }
@@ -102,16 +290,22 @@ void HexMapMeshTool::set_cell_visibility(HexMapCellId cell_id, bool visible) {
     }
 }
 
+bool HexMapMeshTool::set_cell_occluded(HexMapCellId cell_id, bool occluded) {
+    Cell *cell = cell_map.getptr(cell_id);
+    if (cell == nullptr || cell->occluded == occluded) {
+        return false;
+    }
+    cell->occluded = occluded;
+    return true;
+}
+
 void HexMapMeshTool::set_all_cells_visible() {
     for (auto &iter : cell_map) {
         iter.value.visible = true;
     }
 }
 
-void HexMapMeshTool::refresh() {
-    free_multimeshes();
-    build_multimeshes();
-}
+void HexMapMeshTool::refresh() { build_multimeshes(); }
 
 void HexMapMeshTool::clear() {
     free_multimeshes();
@@ -128,6 +322,24 @@ void HexMapMeshTool::set_visible(bool value) {
     }
 }
 
+void HexMapMeshTool::set_visibility_range(real_t begin, real_t end) {
+    if (begin == visibility_range_begin && end == visibility_range_end) {
+        return;
+    }
+    visibility_range_begin = begin;
+    visibility_range_end = end;
+
+    RenderingServer *rs = RenderingServer::get_singleton();
+    for (const MultiMesh &mm : multimeshes) {
+        rs->instance_geometry_set_visibility_range(mm.instance,
+                visibility_range_begin,
+                visibility_range_end,
+                0,
+                0,
+                RenderingServer::VISIBILITY_RANGE_FADE_DISABLED);
+    }
+}
+
 void HexMapMeshTool::enter_world(RID scenario) {
     set_scenario(scenario);
     refresh();
@@ -138,4 +350,20 @@ void HexMapMeshTool::exit_world() {
     free_multimeshes();
 }
 
+size_t HexMapMeshTool::get_multimesh_buffer_size() const {
+    size_t bytes = 0;
+    for (const MultiMesh &mm : multimeshes) {
+        bytes += mm.instance_count * get_buffer_stride() * sizeof(float);
+    }
+    return bytes;
+}
+
+size_t HexMapMeshTool::get_multimesh_buffer_copy_size() const {
+    size_t bytes = 0;
+    for (const MultiMesh &mm : multimeshes) {
+        bytes += mm.buffer.size() * sizeof(float);
+    }
+    return bytes;
+}
+
 HexMapMeshTool::~HexMapMeshTool() { free_multimeshes(); }
@@ -6,7 +6,12 @@
 #include <godot_cpp/classes/standard_material3d.hpp>
 #include <godot_cpp/core/defs.hpp>
 #include <godot_cpp/templates/hash_set.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/templates/pair.hpp>
+#include <godot_cpp/templates/safe_refcount.hpp>
 #include <godot_cpp/templates/vector.hpp>
+#include <godot_cpp/variant/color.hpp>
+#include <godot_cpp/variant/packed_float32_array.hpp>
 #include <godot_cpp/variant/transform3d.hpp>
 
 #include "cell_id.h"
@@ -16,6 +21,23 @@ using namespace godot;
 
 class HexMapMeshTool {
 public:
+    /// location of an instance within the multimeshes
+    struct InstanceSlot {
+        /// index of the multimesh, -1 if the instance is not in a multimesh
+        int32_t multimesh = -1;
+        /// index of the instance within the multimesh
+        int32_t instance = -1;
+    };
+
+    /// mesh instance to add to the multimeshes; see `build_instances()`
+    struct Instance {
+        RID mesh;
+        /// transform within the hex space, including the cell position
+        Transform3D transform;
+        /// per-instance data; see `set_custom_data_format()`
+        Color custom_data = Color(1, 1, 1, 1);
+    };
+
     /// cell state
     struct Cell {
         /// mesh to show in the cell
@@ -24,8 +46,31 @@ public:
         Transform3D transform;
         /// flag for mesh visibility; set to false to exclude from multimesh
         bool visible = true;
+        /// cell is fully enclosed by its neighbors and cannot be seen;
+        /// excluded from multimesh
+        bool occluded = false;
+        /// per-instance data; see `set_custom_data_format()`
+        Color custom_data = Color(1, 1, 1, 1);
+
+        /// multimesh instance for this cell; set when the multimeshes are
+        /// built.
+        InstanceSlot slot;
+    };
+
+    /// where to put the per-cell `custom_data` in the multimesh instances
+    enum CustomDataFormat {
+        /// custom data is not sent to the multimeshes
+        CUSTOM_DATA_NONE,
+        /// per-instance color; `COLOR` in shaders
+        CUSTOM_DATA_COLOR,
+        /// per-instance custom data; `INSTANCE_CUSTOM` in shaders
+        CUSTOM_DATA_CUSTOM,
     };
 
+    /// Performance monitor counters, summed across every HexMapMeshTool
+    static SafeNumeric<int64_t> monitor_multimeshes;
+    static SafeNumeric<int64_t> monitor_instances;
+
     HexMapMeshTool(RID scenario = RID(), uint64_t object_id = 0) :
             scenario(scenario), object_id(object_id) {};
     ~HexMapMeshTool();
@@ -42,8 +87,18 @@ public:
     inline void set_object_id(uint64_t value) { object_id = (ObjectID)value; };
 
     /// Set the hex space parameters
+    ///
+    /// The global transform from the space is applied to any existing mesh
+    /// instances immediately; cell scale changes require a `refresh()`.
     void set_space(const HexMapSpace &);
 
+    /// Set the global transform of the meshes
+    ///
+    /// Instance transforms are stored in local space, so this only updates
+    /// the transform of each multimesh instance, and does not require a
+    /// `refresh()`.
+    void set_transform(const Transform3D &);
+
     /// Get the `HexSpace` for this MeshManager
     inline const HexMapSpace &get_space() const { return space; }
 
@@ -63,6 +118,36 @@ public:
     /// cell will become visible.
     void set_cell_visibility(HexMapCellId, bool visible);
 
+    /// mark a cell as hidden by the cells around it
+    ///
+    /// Occluded cells are not added to the multimeshes.  Unlike visibility,
+    /// the occluded flag is preserved when the cell is set again, as it
+    /// depends on the neighboring cells and not the cell itself.
+    ///
+    /// @return true if the occluded state of the cell changed
+    bool set_cell_occluded(HexMapCellId, bool occluded);
+
+    /// set which multimesh channel the per-cell custom data is sent to;
+    /// takes effect on next `refresh()`
+    inline void set_custom_data_format(CustomDataFormat value) {
+        custom_data_format = value;
+    };
+    inline CustomDataFormat get_custom_data_format() const {
+        return custom_data_format;
+    };
+
+    /// set the custom data for a cell
+    ///
+    /// If the multimeshes have been built, the value is written directly into
+    /// the instance slot for the cell; the multimeshes are not rebuilt.  The
+    /// value is preserved when the cell is set again.
+    void set_cell_custom_data(HexMapCellId, const Color &);
+
+    /// set the custom data for multiple cells; each multimesh buffer touched
+    /// is uploaded once.
+    void set_cells_custom_data(
+            const Vector<Pair<HexMapCellId::Key, Color>> &cells);
+
     /// make all cells in the mesh visible
     ///
     /// This function is provided to easily restore cell visibility without the
@@ -74,9 +159,34 @@ public:
         return cell_map;
     };
 
+    /// bytes of instance data in the multimesh buffers; this memory is owned
+    /// by the RenderingServer
+    size_t get_multimesh_buffer_size() const;
+
+    /// bytes used by the multimesh buffer copies kept for custom data updates
+    size_t get_multimesh_buffer_copy_size() const;
+
     /// update the meshes that are displayed
     void refresh();
 
+    /// Replace the multimeshes with ones built from `instances`, ignoring the
+    /// per-cell state.  This allows callers that keep their own cell state to
+    /// use the HexMapMeshTool without storing a transform for every cell.
+    ///
+    /// @param [instances] mesh instances to draw
+    /// @param [slots] resized to match `instances`, and set to the location
+    ///     of each instance for `set_instance_custom_data()`
+    void build_instances(const LocalVector<Instance> &instances,
+            LocalVector<InstanceSlot> &slots);
+
+    /// set the custom data for an instance without rebuilding the meshes
+    void set_instance_custom_data(InstanceSlot, const Color &);
+
+    /// set the custom data for multiple instances; each multimesh buffer
+    /// touched is uploaded once.
+    void set_instances_custom_data(
+            const LocalVector<Pair<InstanceSlot, Color>> &instances);
+
     /// clear all cells in the mesh
     void clear();
 
@@ -86,6 +196,11 @@ public:
     /// check whether the meshes are visible
     bool get_visible() const;
 
+    /// Set the camera distance range in which the meshes are drawn; see
+    /// `GeometryInstance3D.visibility_range_begin`.  An `end` of 0 disables
+    /// the upper limit.
+    void set_visibility_range(real_t begin, real_t end);
+
     /// helper function to simplify needed calls when hexmap enters world
     void enter_world(RID scenario);
 
@@ -101,8 +216,21 @@ private:
     struct MultiMesh {
         RID multimesh;
         RID instance;
+        /// copy of the multimesh buffer; only kept when custom data is
+        /// enabled so that tint updates can patch & re-upload it.
+        PackedFloat32Array buffer;
+        /// number of instances in the multimesh
+        int64_t instance_count;
     };
 
+    /// format of the per-cell custom data in the multimesh
+    CustomDataFormat custom_data_format = CUSTOM_DATA_NONE;
+
+    /// number of floats per instance in the multimesh buffer
+    inline int get_buffer_stride() const {
+        return custom_data_format == CUSTOM_DATA_NONE ? 12 : 16;
+    }
+
     /// map of cell keys to the visual for each cell
     HashMap<HexMapCellId::Key, Cell> cell_map;
 
@@ -118,6 +246,10 @@ private:
     /// whether the meshes are visible
     bool visible = true;
 
+    /// camera distance range to draw the meshes
+    real_t visibility_range_begin = 0;
+    real_t visibility_range_end = 0;
+
     /// offset of the mesh origin from the geometric center of a unit cell
     ///
     /// To put the origin at the top of the cell, use y = 0.5
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// Morton (Z-order) codes for three 16-bit coordinates.
+//
+// The bits of the coordinates are interleaved, `x` in bit 0, `y` in bit 1,
+// `z` in bit 2, and so on up to bit 47.  Sorting by the resulting code
+// visits space in a Z-shaped curve, so cells that are near each other in
+// space end up near each other in memory.
+//
+// When built with BMI2 (`-mbmi2`, or `-march` for a CPU that has it), the
+// pdep/pext instructions are used.  Otherwise encoding uses a table that
+// spreads a byte at a time, and decoding uses shift & mask compaction.
+
+/// bits used by the x coordinate in a morton code
+static constexpr uint64_t MORTON3_MASK_X = 0x249249249249ull;
+
+#if !defined(__BMI2__)
+// spread the bits of a byte out to every third bit
+static constexpr std::array<uint32_t, 256> morton3_build_table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t value = 0; value < 256; value++) {
+        uint32_t out = 0;
+        for (uint32_t bit = 0; bit < 8; bit++) {
+            out |= ((value >> bit) & 1) << (bit * 3);
+        }
+        table[value] = out;
+    }
+    return table;
+}
+static constexpr std::array<uint32_t, 256> MORTON3_SPREAD_TABLE =
+        morton3_build_table();
+
+static inline uint64_t morton3_spread(uint16_t value) {
+    return (uint64_t)MORTON3_SPREAD_TABLE[value & 0xff] |
+            ((uint64_t)MORTON3_SPREAD_TABLE[value >> 8] << 24);
+}
+
+static inline uint16_t morton3_compact(uint64_t value) {
+    value &= MORTON3_MASK_X;
+    value = (value ^ (value >> 2)) & 0x30c30c30c30c3ull;
+    value = (value ^ (value >> 4)) & 0xf00f00f00f00full;
+    value = (value ^ (value >> 8)) & 0xff0000ff0000ffull;
+    value = (value ^ (value >> 16)) & 0xffff00000000ffffull;
+    value = (value ^ (value >> 32)) & 0xffff;
+    return (uint16_t)value;
+}
+#endif
+
+/// interleave three 16-bit coordinates into a 48-bit morton code
+static inline uint64_t morton3_encode(uint16_t x, uint16_t y, uint16_t z) {
+#if defined(__BMI2__)
+    return _pdep_u64(x, MORTON3_MASK_X) | _pdep_u64(y, MORTON3_MASK_X << 1) |
+            _pdep_u64(z, MORTON3_MASK_X << 2);
+#else
+    return morton3_spread(x) | (morton3_spread(y) << 1) |
+            (morton3_spread(z) << 2);
+#endif
+}
+
+/// split a morton code from morton3_encode() back into its coordinates
+static inline void morton3_decode(uint64_t code,
+        uint16_t &x,
+        uint16_t &y,
+        uint16_t &z) {
+#if defined(__BMI2__)
+    x = _pext_u64(code, MORTON3_MASK_X);
+    y = _pext_u64(code, MORTON3_MASK_X << 1);
+    z = _pext_u64(code, MORTON3_MASK_X << 2);
+#else
+    x = morton3_compact(code);
+    y = morton3_compact(code >> 1);
+    z = morton3_compact(code >> 2);
+#endif
+}
@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/error_macros.hpp>
+#include <godot_cpp/core/math.hpp>
+#include <godot_cpp/core/object.hpp>
+
+#include "pathfinder.h"
+#include "profiling.h"
+
+void HexMapPathfinder::_bind_methods() {
+    ClassDB::bind_method(
+            D_METHOD("set_map", "map"), &HexMapPathfinder::set_map);
+    ClassDB::bind_method(D_METHOD("get_map"), &HexMapPathfinder::get_map);
+    ClassDB::bind_method(D_METHOD("set_walkable_values", "values"),
+            &HexMapPathfinder::set_walkable_values);
+    ClassDB::bind_method(D_METHOD("get_walkable_values"),
+            &HexMapPathfinder::get_walkable_values);
+    ClassDB::bind_method(D_METHOD("set_value_cost", "value", "cost"),
+            &HexMapPathfinder::set_value_cost);
+    ClassDB::bind_method(D_METHOD("get_value_cost", "value"),
+            &HexMapPathfinder::get_value_cost);
+    ClassDB::bind_method(D_METHOD("set_max_step_up", "steps"),
+            &HexMapPathfinder::set_max_step_up);
+    ClassDB::bind_method(
+            D_METHOD("get_max_step_up"), &HexMapPathfinder::get_max_step_up);
+    ClassDB::bind_method(D_METHOD("set_max_step_down", "steps"),
+            &HexMapPathfinder::set_max_step_down);
+    ClassDB::bind_method(D_METHOD("get_max_step_down"),
+            &HexMapPathfinder::get_max_step_down);
+    ClassDB::bind_method(D_METHOD("is_cell_walkable", "cell"),
+            &HexMapPathfinder::_is_cell_walkable);
+    ClassDB::bind_method(D_METHOD("find_path", "from", "to"),
+            &HexMapPathfinder::_find_path);
+    ClassDB::bind_method(
+            D_METHOD("build_flow_field", "goals", "max_distance"),
+            &HexMapPathfinder::_build_flow_field,
+            DEFVAL(Math_INF));
+    ClassDB::bind_method(
+            D_METHOD("invalidate"), &HexMapPathfinder::invalidate);
+
+    ADD_PROPERTY(PropertyInfo(Variant::OBJECT,
+                         "map",
+                         PROPERTY_HINT_NODE_TYPE,
+                         "HexMapNode"),
+            "set_map",
+            "get_map");
+    ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT32_ARRAY, "walkable_values"),
+            "set_walkable_values",
+            "get_walkable_values");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "max_step_up"),
+            "set_max_step_up",
+            "get_max_step_up");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "max_step_down"),
+            "set_max_step_down",
+            "get_max_step_down");
+}
+
+void HexMapPathfinder::set_map(HexMapNode *map) {
+    if (get_map() == map) {
+        return;
+    }
+    map_id = map != nullptr ? ObjectID(map->get_instance_id()) : ObjectID();
+    if (map != nullptr) {
+        cells_version = map->get_cells_version();
+    }
+    invalidate();
+}
+
+HexMapNode *HexMapPathfinder::get_map() const {
+    if (map_id.is_null()) {
+        return nullptr;
+    }
+    return Object::cast_to<HexMapNode>(ObjectDB::get_instance(map_id));
+}
+
+void HexMapPathfinder::set_walkable_values(const PackedInt32Array &values) {
+    walkable_values.clear();
+    for (int value : values) {
+        walkable_values.insert(value);
+    }
+    invalidate();
+}
+
+PackedInt32Array HexMapPathfinder::get_walkable_values() const {
+    PackedInt32Array out;
+    for (int value : walkable_values) {
+        out.push_back(value);
+    }
+    return out;
+}
+
+void HexMapPathfinder::set_value_cost(int value, float cost) {
+    ERR_FAIL_COND_MSG(cost <= 0, "cost must be positive");
+    value_costs[value] = cost;
+    invalidate();
+}
+
+float HexMapPathfinder::get_value_cost(int value) const {
+    const float *cost = value_costs.getptr(value);
+    return cost != nullptr ? *cost : 1.0;
+}
+
+void HexMapPathfinder::set_max_step_up(int value) {
+    ERR_FAIL_COND_MSG(value < 0, "max_step_up must not be negative");
+    max_step_up = value;
+}
+
+int HexMapPathfinder::get_max_step_up() const { return max_step_up; }
+
+void HexMapPathfinder::set_max_step_down(int value) {
+    ERR_FAIL_COND_MSG(value < 0, "max_step_down must not be negative");
+    max_step_down = value;
+}
+
+int HexMapPathfinder::get_max_step_down() const { return max_step_down; }
+
+void HexMapPathfinder::invalidate() {
+    cell_costs.clear();
+
+    // the heuristic must never overestimate, so it uses the cheapest cost
+    // a path could have per cell
+    min_cost = walkable_values.is_empty() ? 1.0 : Math_INF;
+    for (int value : walkable_values) {
+        min_cost = MIN(min_cost, get_value_cost(value));
+    }
+}
+
+void HexMapPathfinder::sync_cells_version(const HexMapNode &map) {
+    // Every mutation path (set_cell(), clear(), scene loading) bumps the
+    // version, so compare it once per query rather than relying on the
+    // `cells_changed` signal, which only the GDScript setters emit.
+    uint64_t version = map.get_cells_version();
+    if (version != cells_version) {
+        cells_version = version;
+        cell_costs.clear();
+    }
+}
+
+float HexMapPathfinder::get_cell_cost(const HexMapNode &map,
+        const HexMapCellId &cell) {
+    const float *cached = cell_costs.getptr(cell);
+    if (cached != nullptr) {
+        return *cached;
+    }
+
+    float cost = -1;
+    int value = map.get_cell(cell).value;
+    if (value != HexMapNode::CELL_VALUE_NONE && walkable_values.has(value) &&
+            !map.has(cell + HexMapCellId(0, 0, 1))) {
+        cost = get_value_cost(value);
+    }
+    cell_costs.insert(cell, cost);
+    return cost;
+}
+
+float HexMapPathfinder::estimate_cost(const HexMapCellId &a,
+        const HexMapCellId &b) const {
+    // height changes are free, so only the horizontal distance counts
+    HexMapCellId delta = b - a;
+    unsigned distance =
+            (ABS(delta.q) + ABS(delta.q + delta.r) + ABS(delta.r)) / 2;
+    return distance * min_cost;
+}
+
+bool HexMapPathfinder::is_cell_walkable(const HexMapCellId &cell) {
+    HexMapNode *map = get_map();
+    ERR_FAIL_NULL_V_MSG(map, false, "map not set");
+    sync_cells_version(*map);
+    return get_cell_cost(*map, cell) >= 0;
+}
+
+bool HexMapPathfinder::_is_cell_walkable(Vector3i cell) {
+    return is_cell_walkable(cell);
+}
+
+Vector<HexMapCellId> HexMapPathfinder::find_path(const HexMapCellId &from,
+        const HexMapCellId &to) {
+    auto profiler = profiling_begin("HexMapPathfinder::find_path()");
+
+    Vector<HexMapCellId> path;
+    HexMapNode *map = get_map();
+    ERR_FAIL_NULL_V_MSG(map, path, "map not set");
+    ERR_FAIL_COND_V(!from.in_bounds() || !to.in_bounds(), path);
+    sync_cells_version(*map);
+    if (get_cell_cost(*map, from) < 0 || get_cell_cost(*map, to) < 0) {
+        return path;
+    }
+
+    CellKey goal = to;
+    open.clear();
+    visits.clear();
+    visits.insert(from, Visit{ .cost = 0, .parent = from });
+    open.push_back(OpenEntry{
+            .estimate = estimate_cost(from, to),
+            .cost = 0,
+            .key = from,
+    });
+
+    bool found = false;
+    while (!open.is_empty()) {
+        std::pop_heap(open.ptr(), open.ptr() + open.size());
+        OpenEntry entry = open[open.size() - 1];
+        open.resize(open.size() - 1);
+
+        // skip stale entries for cells that were reached more cheaply
+        Visit *visit = visits.getptr(entry.key);
+        if (visit->closed || entry.cost > visit->cost) {
+            continue;
+        }
+        visit->closed = true;
+        if (entry.key == goal) {
+            found = true;
+            break;
+        }
+
+        HexMapCellId cell = entry.key;
+        // the neighbor columns; the height is searched within the step
+        // limits
+        for (const HexMapCellId &offset : HexMapCellId::DIRECTIONS) {
+            HexMapCellId column = cell + offset;
+            for (int step = -max_step_down; step <= max_step_up; step++) {
+                HexMapCellId next = column + HexMapCellId(0, 0, step);
+                if (!next.in_bounds()) {
+                    continue;
+                }
+                float cell_cost = get_cell_cost(*map, next);
+                if (cell_cost < 0) {
+                    continue;
+                }
+
+                float cost = entry.cost + cell_cost;
+                Visit *next_visit = visits.getptr(next);
+                if (next_visit == nullptr) {
+                    visits.insert(next, Visit{ .cost = cost, .parent = cell });
+                } else if (next_visit->closed || next_visit->cost <= cost) {
+                    continue;
+                } else {
+                    next_visit->cost = cost;
+                    next_visit->parent = cell;
+                }
+
+                open.push_back(OpenEntry{
+                        .estimate = cost + estimate_cost(next, to),
+                        .cost = cost,
+                        .key = next,
+                });
+                std::push_heap(open.ptr(), open.ptr() + open.size());
+            }
+        }
+    }
+
+    if (!found) {
+        return path;
+    }
+
+    for (CellKey key = goal;; key = visits[key].parent) {
+        path.push_back(key);
+        if (key == CellKey(from)) {
+            break;
+        }
+    }
+    path.reverse();
+    return path;
+}
+
+PackedVector3Array HexMapPathfinder::_find_path(Vector3i from, Vector3i to) {
+    return HexMapCellId::to_packed_vecs(find_path(from, to));
+}
+
+Ref<HexMapFlowField> HexMapPathfinder::build_flow_field(
+        const Vector<HexMapCellId> &goals,
+        float max_distance) {
+    auto profiler = profiling_begin("HexMapPathfinder::build_flow_field()");
+
+    Ref<HexMapFlowField> field;
+    HexMapNode *map = get_map();
+    ERR_FAIL_NULL_V_MSG(map, field, "map not set");
+    sync_cells_version(*map);
+    field.instantiate();
+
+    // snapshot the walkable cells so the worker never touches the map
+    HexMapFlowField::Params &params = field->params;
+    const Array cells = map->get_cell_vecs();
+    for (int i = 0; i < cells.size(); i++) {
+        HexMapCellId cell = (Vector3i)cells[i];
+        float cost = get_cell_cost(*map, cell);
+        if (cost >= 0) {
+            params.costs.insert(cell, cost);
+        }
+    }
+    for (const HexMapCellId &goal : goals) {
+        params.goals.push_back(goal);
+    }
+    params.max_step_up = max_step_up;
+    params.max_step_down = max_step_down;
+    params.max_distance = max_distance;
+
+    field->start();
+    return field;
+}
+
+Ref<HexMapFlowField> HexMapPathfinder::_build_flow_field(
+        const PackedVector3Array &goals,
+        float max_distance) {
+    Vector<HexMapCellId> cells;
+    cells.resize(goals.size());
+    for (int i = 0; i < goals.size(); i++) {
+        cells.set(i, Vector3i(goals[i]));
+    }
+    return build_flow_field(cells, max_distance);
+}
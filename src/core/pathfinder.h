@@ -0,0 +1,135 @@
+#pragma once
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/object_id.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/hash_set.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+#include <godot_cpp/variant/packed_vector3_array.hpp>
+#include <godot_cpp/variant/vector3i.hpp>
+
+#include "cell_id.h"
+#include "cell_map.h"
+#include "flow_field.h"
+#include "hex_map_node.h"
+
+using namespace godot;
+
+/// A* pathfinding over the cells of a `HexMapNode`.
+///
+/// A cell can be stood on when its value is one of the walkable values, and
+/// the cell above it is empty.  From a cell, a path can move to a standable
+/// cell in any of the six neighboring columns, as long as the height change
+/// is within `max_step_up` and `max_step_down`.  The cost of moving onto a
+/// cell is the cost of its value; 1.0 unless set with `set_value_cost()`.
+///
+/// The cell map is read directly, and the per-cell results are cached.  The
+/// cache is dropped whenever the cells version of the `HexMapNode` changes,
+/// so there is no graph to rebuild when the map changes.  The search buffers
+/// are kept between queries to avoid reallocating them.
+class HexMapPathfinder : public RefCounted {
+    GDCLASS(HexMapPathfinder, RefCounted)
+
+    using CellKey = HexMapCellId::Key;
+
+public:
+    HexMapPathfinder() {};
+
+    void set_map(HexMapNode *);
+    HexMapNode *get_map() const;
+
+    void set_walkable_values(const PackedInt32Array &);
+    PackedInt32Array get_walkable_values() const;
+
+    /// set the cost of moving onto a cell with `value`; must be positive
+    void set_value_cost(int value, float cost);
+    float get_value_cost(int value) const;
+
+    void set_max_step_up(int);
+    int get_max_step_up() const;
+    void set_max_step_down(int);
+    int get_max_step_down() const;
+
+    /// check if a path can stand on a cell
+    bool is_cell_walkable(const HexMapCellId &);
+    bool _is_cell_walkable(Vector3i);
+
+    /// find the cheapest path between two walkable cells
+    ///
+    /// @returns the cell ids along the path, including `from` and `to`, or
+    /// an empty Vector if no path exists.
+    Vector<HexMapCellId> find_path(const HexMapCellId &from,
+            const HexMapCellId &to);
+
+    /// gdscript wrapper for find_path(); returns the cell ids as Vector3
+    PackedVector3Array _find_path(Vector3i from, Vector3i to);
+
+    /// build a flow field toward the nearest of `goals` on a worker thread
+    ///
+    /// The walkable cells are gathered from the map on the calling thread,
+    /// so later map changes do not affect the field.
+    ///
+    /// @param goals walkable cells to find paths to
+    /// @param max_distance cells further from every goal are not reached
+    Ref<HexMapFlowField> build_flow_field(const Vector<HexMapCellId> &goals,
+            float max_distance = Math_INF);
+
+    /// gdscript wrapper for build_flow_field(); `goals` are cell ids
+    Ref<HexMapFlowField> _build_flow_field(const PackedVector3Array &goals,
+            float max_distance = Math_INF);
+
+    /// discard all cached cell data
+    void invalidate();
+
+protected:
+    static void _bind_methods();
+
+private:
+    /// entry in the A* open list
+    struct OpenEntry {
+        /// estimated total cost of a path through this cell
+        float estimate;
+        float cost;
+        CellKey key;
+
+        // reversed so the std heap functions build a min-heap
+        inline bool operator<(const OpenEntry &other) const {
+            return estimate > other.estimate;
+        }
+    };
+
+    /// search state for a cell reached during a query
+    struct Visit {
+        float cost;
+        CellKey parent;
+        bool closed = false;
+    };
+
+    /// cost of moving onto a cell, or a negative value if the cell cannot
+    /// be stood on; cached in `cell_costs`.
+    float get_cell_cost(const HexMapNode &, const HexMapCellId &);
+
+    /// lower bound of the cost between two cells for the A* heuristic
+    float estimate_cost(const HexMapCellId &, const HexMapCellId &) const;
+
+    /// drop the cached cell costs if the map cells were modified since they
+    /// were cached
+    void sync_cells_version(const HexMapNode &);
+
+    ObjectID map_id;
+    HashSet<int> walkable_values;
+    HashMap<int, float> value_costs;
+    /// lowest cost of any walkable value
+    float min_cost = 1.0;
+    int max_step_up = 1;
+    int max_step_down = 1;
+
+    HexMapCellMap<float> cell_costs;
+    /// `HexMapNode::get_cells_version()` when `cell_costs` was last cleared
+    uint64_t cells_version = 0;
+
+    // buffers reused between queries; clear() keeps their allocations
+    LocalVector<OpenEntry> open;
+    HexMapCellMap<Visit> visits;
+};
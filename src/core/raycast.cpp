@@ -0,0 +1,86 @@
+#include <godot_cpp/core/math.hpp>
+
+#include "math.h"
+#include "raycast.h"
+
+// side faces of the unit hex prism; the neighbor offset through the face, and
+// the outward face normal.  Every side face is Math_SQRT3_2 from the center.
+static const struct {
+    HexMapCellId offset;
+    Vector3 normal;
+} side_faces[6] = {
+    { HexMapCellId(1, 0, 0), Vector3(1, 0, 0) },
+    { HexMapCellId(1, -1, 0), Vector3(0.5, 0, -Math_SQRT3_2) },
+    { HexMapCellId(0, -1, 0), Vector3(-0.5, 0, -Math_SQRT3_2) },
+    { HexMapCellId(-1, 0, 0), Vector3(-1, 0, 0) },
+    { HexMapCellId(-1, 1, 0), Vector3(-0.5, 0, Math_SQRT3_2) },
+    { HexMapCellId(0, 1, 0), Vector3(0.5, 0, Math_SQRT3_2) },
+};
+
+HexMapRaycast::HexMapRaycast(const Vector3 &from, const Vector3 &to) :
+        cell(HexMapCellId::from_unit_point(from)),
+        from(from),
+        direction(to - from) {
+    // every step crosses a single face; a straight segment zig-zags across
+    // at most about twice as many faces as the distance between its end
+    // cells, so this only trips on bad input.
+    unsigned distance = cell.distance(HexMapCellId::from_unit_point(to));
+    steps_remaining = distance * 3 + 8;
+}
+
+bool HexMapRaycast::next() {
+    if (steps_remaining == 0) {
+        return false;
+    }
+
+    // find the face the segment exits the current cell through; only faces
+    // the segment is moving toward can be exits, and the nearest is the one
+    // crossed first.
+    Vector3 origin = from - cell.unit_center();
+    real_t exit_t = Math_INF;
+    HexMapCellId exit_offset;
+    Vector3 exit_normal;
+
+    for (const auto &face : side_faces) {
+        real_t speed = direction.dot(face.normal);
+        if (speed <= CMP_EPSILON) {
+            continue;
+        }
+        real_t t = (Math_SQRT3_2 - origin.dot(face.normal)) / speed;
+        if (t < exit_t) {
+            exit_t = t;
+            exit_offset = face.offset;
+            exit_normal = face.normal;
+        }
+    }
+
+    if (direction.y > CMP_EPSILON) {
+        real_t t = (0.5 - origin.y) / direction.y;
+        if (t < exit_t) {
+            exit_t = t;
+            exit_offset = HexMapCellId(0, 0, 1);
+            exit_normal = Vector3(0, 1, 0);
+        }
+    } else if (direction.y < -CMP_EPSILON) {
+        real_t t = (-0.5 - origin.y) / direction.y;
+        if (t < exit_t) {
+            exit_t = t;
+            exit_offset = HexMapCellId(0, 0, -1);
+            exit_normal = Vector3(0, -1, 0);
+        }
+    }
+
+    // segment ends within this cell
+    if (exit_t > 1) {
+        return false;
+    }
+
+    cell = cell + exit_offset;
+    // rounding near cell corners can put the exit slightly before the entry;
+    // keep the walk moving forward.
+    entry_t = MAX(exit_t, entry_t);
+    entry_normal = -exit_normal;
+    steps_remaining--;
+
+    return cell.in_bounds();
+}
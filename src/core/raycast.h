@@ -0,0 +1,50 @@
+#pragma once
+
+#include <godot_cpp/variant/vector3.hpp>
+
+#include "cell_id.h"
+
+using namespace godot;
+
+/// Walk every cell crossed by a line segment on the unit hex grid
+/// (`radius = 1`, `height = 1`).
+///
+/// Each cell is a convex hexagonal prism, so the walk finds the face the
+/// segment exits through, and steps to the neighbor on the other side of
+/// that face; similar to a 3D DDA, but with six side faces in place of four.
+/// No cell data is read; the caller decides when to stop.
+///
+/// ```
+/// HexMapRaycast ray(from, to);
+/// do {
+///     if (has(ray.cell)) { ... }
+/// } while (ray.next());
+/// ```
+class HexMapRaycast {
+public:
+    HexMapRaycast(const Vector3 &from, const Vector3 &to);
+
+    /// step to the next cell along the segment; returns false when the
+    /// segment ends within the current cell.
+    bool next();
+
+    /// point along the segment at `t`
+    inline Vector3 get_point(real_t t) const { return from + direction * t; }
+
+    /// current cell
+    HexMapCellId cell;
+
+    /// segment parameter, [0, 1], where the segment entered `cell`
+    real_t entry_t = 0;
+
+    /// outward normal of the face the segment entered `cell` through; zero
+    /// for the cell containing the start of the segment
+    Vector3 entry_normal;
+
+private:
+    Vector3 from;
+    Vector3 direction;
+
+    /// guard against looping forever on degenerate input
+    unsigned steps_remaining;
+};
@@ -0,0 +1,80 @@
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/error_macros.hpp>
+
+#include "iter_radial.h"
+#include "snapshot.h"
+
+void HexMapSnapshot::_bind_methods() {
+    ClassDB::bind_method(
+            D_METHOD("get_cell", "cell"), &HexMapSnapshot::_get_cell);
+    ClassDB::bind_method(D_METHOD("get_cell_value", "cell"),
+            &HexMapSnapshot::get_cell_value);
+    ClassDB::bind_method(D_METHOD("has", "cell"), &HexMapSnapshot::_has);
+    ClassDB::bind_method(D_METHOD("get_cell_count"),
+            &HexMapSnapshot::get_cell_count);
+    ClassDB::bind_method(
+            D_METHOD("get_cell_vecs"), &HexMapSnapshot::get_cell_vecs);
+    ClassDB::bind_method(D_METHOD("get_occupied_neighbor_vecs",
+                                 "cell",
+                                 "radius",
+                                 "include_self"),
+            &HexMapSnapshot::get_occupied_neighbor_vecs,
+            DEFVAL(1),
+            DEFVAL(false));
+}
+
+HexMapSnapshot::CellInfo HexMapSnapshot::get_cell(
+        const HexMapCellId &cell_id) const {
+    const CellInfo *info = cells.getptr(cell_id);
+    if (info == nullptr) {
+        return CellInfo{ .value = HexMapNode::CELL_VALUE_NONE };
+    }
+    return *info;
+}
+
+Dictionary HexMapSnapshot::_get_cell(Vector3i cell_vec) const {
+    Dictionary out;
+    CellInfo info = get_cell(cell_vec);
+    out["value"] = info.value;
+    out["orientation"] = info.orientation;
+    return out;
+}
+
+int HexMapSnapshot::get_cell_value(Vector3i cell_vec) const {
+    return get_cell(cell_vec).value;
+}
+
+bool HexMapSnapshot::has(const HexMapCellId &cell_id) const {
+    return cells.has(cell_id);
+}
+
+bool HexMapSnapshot::_has(Vector3i cell_vec) const { return has(cell_vec); }
+
+int HexMapSnapshot::get_cell_count() const { return cells.size(); }
+
+PackedVector3Array HexMapSnapshot::get_cell_vecs() const {
+    PackedVector3Array out;
+    out.resize(cells.size());
+    Vector3 *ptr = out.ptrw();
+    int i = 0;
+    for (const auto &iter : cells) {
+        ptr[i++] = Vector3(HexMapCellId(iter.key).to_vec());
+    }
+    return out;
+}
+
+PackedVector3Array HexMapSnapshot::get_occupied_neighbor_vecs(
+        Vector3i cell_vec,
+        int radius,
+        bool include_self) const {
+    PackedVector3Array out;
+    ERR_FAIL_COND_V_MSG(radius < 0, out, "radius must not be negative");
+    HexMapCellId center = cell_vec;
+    for (const HexMapCellId &cell :
+            center.get_neighbors(radius, HexMapPlanes::All, include_self)) {
+        if (has(cell)) {
+            out.push_back(Vector3(cell.to_vec()));
+        }
+    }
+    return out;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/packed_vector3_array.hpp>
+#include <godot_cpp/variant/vector3i.hpp>
+
+#include "cell_id.h"
+#include "cell_map.h"
+#include "hex_map_node.h"
+
+using namespace godot;
+
+/// Read-only copy of the cells in a `HexMapNode`.
+///
+/// Created by `HexMapNode.get_snapshot()` on the main thread.  A snapshot
+/// never changes once created, so any number of threads, such as
+/// WorkerThreadPool tasks, can read it while the main thread keeps editing
+/// the map.  Edits made after the snapshot was taken are not visible in it;
+/// take a new snapshot to see them.
+class HexMapSnapshot : public RefCounted {
+    GDCLASS(HexMapSnapshot, RefCounted)
+
+    friend class HexMapNode;
+
+public:
+    using CellInfo = HexMapNode::CellInfo;
+    using CellMap = HexMapCellMap<CellInfo>;
+
+    HexMapSnapshot() {};
+
+    /// get the info for a single cell
+    CellInfo get_cell(const HexMapCellId &) const;
+    Dictionary _get_cell(Vector3i) const;
+
+    /// get the value of a single cell, or `CELL_VALUE_NONE` if not set
+    int get_cell_value(Vector3i) const;
+
+    /// check if the cell was set when the snapshot was taken
+    bool has(const HexMapCellId &) const;
+    bool _has(Vector3i) const;
+
+    /// number of cells in the snapshot
+    int get_cell_count() const;
+
+    /// get every cell id in the snapshot as a Vector3i
+    PackedVector3Array get_cell_vecs() const;
+
+    /// return the occupied cells within `radius` of `cell`
+    /// @see HexMapNode.get_occupied_neighbor_vecs()
+    PackedVector3Array get_occupied_neighbor_vecs(Vector3i cell,
+            int radius = 1,
+            bool include_self = false) const;
+
+    /// direct access to the cells for C++ callers
+    inline const CellMap &get_cells() const { return cells; }
+
+protected:
+    static void _bind_methods();
+
+private:
+    CellMap cells;
+};
@@ -1,12 +1,17 @@
-#include <godot_cpp/classes/geometry2d.hpp>
 #include <godot_cpp/classes/global_constants.hpp>
 #include <godot_cpp/classes/rendering_server.hpp>
+#include <godot_cpp/classes/standard_material3d.hpp>
 #include <godot_cpp/core/error_macros.hpp>
 #include <godot_cpp/variant/packed_int32_array.hpp>
 #include <godot_cpp/variant/packed_vector3_array.hpp>
 
+#if !defined(REAL_T_IS_DOUBLE) &&                                             \
+        (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+#include <emmintrin.h>
+#define HEX_MAP_SPACE_SSE2
+#endif
+
 #include "cell_id.h"
-#include "iter_cube.h"
 #include "math.h"
 #include "profiling.h"
 #include "space.h"
@@ -21,6 +26,97 @@ void HexMapSpace::set_cell_radius(real_t value) {
     cell_scale.x = cell_scale.z = value;
 }
 
+#ifdef HEX_MAP_SPACE_SSE2
+// round half away from zero, like std::round(); valid for |v| < 2^31
+static inline __m128 round_sse2(__m128 v) {
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    __m128 sign = _mm_and_ps(v, sign_mask);
+    __m128 abs = _mm_andnot_ps(sign_mask, v);
+    __m128 trunc = _mm_cvtepi32_ps(_mm_cvttps_epi32(abs));
+    __m128 up = _mm_cmpge_ps(_mm_sub_ps(abs, trunc), _mm_set1_ps(0.5f));
+    trunc = _mm_add_ps(trunc, _mm_and_ps(up, _mm_set1_ps(1.0f)));
+    return _mm_or_ps(trunc, sign);
+}
+
+static inline __m128 abs_sse2(__m128 v) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+#endif
+
+// shared by both get_cell_ids(); `Cell` is HexMapCellId or HexMapCellId::Key
+template <typename Cell>
+static void points_to_cells(const Vector3 &cell_scale,
+        const Vector3 *local_points,
+        size_t count,
+        Cell *out) {
+    size_t i = 0;
+
+#ifdef HEX_MAP_SPACE_SSE2
+    const __m128 scale_x = _mm_set1_ps(cell_scale.x);
+    const __m128 scale_y = _mm_set1_ps(cell_scale.y);
+    const __m128 scale_z = _mm_set1_ps(cell_scale.z);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    for (; i + 4 <= count; i += 4) {
+        const Vector3 *p = local_points + i;
+        __m128 x = _mm_div_ps(_mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x),
+                scale_x);
+        __m128 y = _mm_div_ps(_mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y),
+                scale_y);
+        __m128 z = _mm_div_ps(_mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z),
+                scale_z);
+
+        // same steps as HexMapCellId::from_unit_point(), four points at a
+        // time
+        __m128 q_in = _mm_sub_ps(
+                _mm_mul_ps(_mm_set1_ps((float)(Math_SQRT3 / 3)), x),
+                _mm_mul_ps(_mm_set1_ps((float)(1.0 / 3)), z));
+        __m128 r_in = _mm_mul_ps(_mm_set1_ps((float)(2.0 / 3)), z);
+        __m128 q = round_sse2(q_in);
+        __m128 r = round_sse2(r_in);
+        __m128 q_rem = _mm_sub_ps(q_in, q);
+        __m128 r_rem = _mm_sub_ps(r_in, r);
+        __m128 adjust_q = _mm_cmpge_ps(abs_sse2(q_rem), abs_sse2(r_rem));
+        __m128 dq = round_sse2(_mm_add_ps(_mm_mul_ps(half, r_rem), q_rem));
+        __m128 dr = round_sse2(_mm_add_ps(_mm_mul_ps(half, q_rem), r_rem));
+        q = _mm_add_ps(q, _mm_and_ps(adjust_q, dq));
+        r = _mm_add_ps(r, _mm_andnot_ps(adjust_q, dr));
+
+        alignas(16) int32_t qs[4], rs[4], ys[4];
+        _mm_store_si128((__m128i *)qs, _mm_cvttps_epi32(q));
+        _mm_store_si128((__m128i *)rs, _mm_cvttps_epi32(r));
+        _mm_store_si128((__m128i *)ys, _mm_cvttps_epi32(round_sse2(y)));
+        for (int j = 0; j < 4; j++) {
+            out[i + j] = HexMapCellId(qs[j], rs[j], ys[j]);
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = HexMapCellId::from_unit_point(local_points[i] / cell_scale);
+    }
+}
+
+void HexMapSpace::get_cell_ids(const Vector3 *local_points,
+        size_t count,
+        HexMapCellId *out) const {
+    points_to_cells(cell_scale, local_points, count, out);
+}
+
+void HexMapSpace::get_cell_ids(const Vector3 *local_points,
+        size_t count,
+        HexMapCellId::Key *out) const {
+    points_to_cells(cell_scale, local_points, count, out);
+}
+
+void HexMapSpace::get_cell_centers(const HexMapCellId::Key *cells,
+        size_t count,
+        Vector3 *out) const {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = HexMapCellId(cells[i]).unit_center() * cell_scale;
+    }
+}
+
 PackedVector3Array HexMapSpace::get_cell_vertices(Vector3 scale) const {
     // PERMANENT NOTE TO SELF:
     // Do not try to move the hex cell vertices into a static const in this
@@ -185,6 +281,82 @@ Ref<ArrayMesh> HexMapSpace::build_cell_mesh() const {
     return mesh;
 }
 
+Ref<ArrayMesh> HexMapSpace::build_placeholder_mesh() const {
+    Ref<StandardMaterial3D> surface_mat;
+    surface_mat.instantiate();
+    surface_mat->set_albedo(Color(1.7, 0.1, 0.1, 0.7));
+    surface_mat->set_shading_mode(StandardMaterial3D::SHADING_MODE_UNSHADED);
+    surface_mat->set_flag(StandardMaterial3D::FLAG_DISABLE_FOG, true);
+    surface_mat->set_transparency(StandardMaterial3D::TRANSPARENCY_ALPHA);
+
+    Ref<ArrayMesh> mesh = build_cell_mesh();
+    mesh->surface_set_material(0, surface_mat);
+    return mesh;
+}
+
+// Same test as Geometry2D::point_is_inside_triangle(), without the trip
+// through the engine.
+static inline bool point_in_triangle(const Vector2 &s,
+        const Vector2 &a,
+        const Vector2 &b,
+        const Vector2 &c) {
+    Vector2 an = a - s;
+    Vector2 bn = b - s;
+    Vector2 cn = c - s;
+    bool orientation = an.cross(bn) > 0;
+    if ((bn.cross(cn) > 0) != orientation) {
+        return false;
+    }
+    return (cn.cross(an) > 0) == orientation;
+}
+
+// Clip a convex polygon against the half-space `sign * point[axis] <= bound`.
+// Each call adds at most one vertex to the polygon.
+static int clip_polygon(const Vector3 *in,
+        int count,
+        Vector3 *out,
+        int axis,
+        real_t sign,
+        real_t bound) {
+    int out_count = 0;
+    for (int i = 0; i < count; i++) {
+        const Vector3 &cur = in[i];
+        const Vector3 &next = in[(i + 1) % count];
+        real_t cur_dist = sign * cur[axis] - bound;
+        real_t next_dist = sign * next[axis] - bound;
+        if (cur_dist <= 0) {
+            out[out_count++] = cur;
+        }
+        if ((cur_dist <= 0) != (next_dist <= 0)) {
+            out[out_count++] =
+                    cur + (next - cur) * (cur_dist / (cur_dist - next_dist));
+        }
+    }
+    return out_count;
+}
+
+// Clip a triangle to the box `min <= point[y,z] <= max`, and widen `x_min`
+// and `x_max` to cover what remains.
+static void clip_triangle_x_range(const Vector3 &a,
+        const Vector3 &b,
+        const Vector3 &c,
+        const Vector3 &min,
+        const Vector3 &max,
+        real_t &x_min,
+        real_t &x_max) {
+    // three vertices, plus one for each of the four clip planes
+    Vector3 buf[2][7] = { { a, b, c } };
+    int count = 3;
+    count = clip_polygon(buf[0], count, buf[1], Vector3::AXIS_Y, -1, -min.y);
+    count = clip_polygon(buf[1], count, buf[0], Vector3::AXIS_Y, 1, max.y);
+    count = clip_polygon(buf[0], count, buf[1], Vector3::AXIS_Z, -1, -min.z);
+    count = clip_polygon(buf[1], count, buf[0], Vector3::AXIS_Z, 1, max.z);
+    for (int i = 0; i < count; i++) {
+        x_min = MIN(x_min, buf[0][i].x);
+        x_max = MAX(x_max, buf[0][i].x);
+    }
+}
+
 Vector<HexMapCellId> HexMapSpace::get_cell_ids_in_local_quad(Vector3 a,
         Vector3 b,
         Vector3 c,
@@ -195,8 +367,7 @@ Vector<HexMapCellId> HexMapSpace::get_cell_ids_in_local_quad(Vector3 a,
             "HexMapSpace::get_cell_ids_in_quad(): invalid padding value;"
             "must be `0 < padding <= 1`");
 
-    // We convert the points to unit space because HexMapIterCube does not
-    // currently provide a mechanism to iterate in non-unit space.
+    // work in unit space so cell centers & vertices are fixed
     a /= cell_scale;
     b /= cell_scale;
     c /= cell_scale;
@@ -210,16 +381,11 @@ Vector<HexMapCellId> HexMapSpace::get_cell_ids_in_local_quad(Vector3 a,
             "HexMapSpace::get_cell_ids_in_quad(): quad points must all be on "
             "the same plane");
 
-    // create a hex space cube iterator to enumerate every hex cell id within
-    // the cube defined by the top-right, bottom-left points
-    Vector3 top_right = a.max(b).max(c).max(d);
-    Vector3 bottom_left = a.min(b).min(c).min(d);
-    HexMapIterCube iter(top_right, bottom_left);
-
     // we're going to reduce the 3d problem to 2d by using the planes that
     // are most perpendicular to the plane normal.
+    int normal_axis = plane.normal.abs().max_axis_index();
     int axis[2];
-    switch (plane.normal.abs().max_axis_index()) {
+    switch (normal_axis) {
     case godot::Vector3::AXIS_X:
         axis[0] = Vector3::AXIS_Y;
         axis[1] = Vector3::AXIS_Z;
@@ -243,51 +409,109 @@ Vector<HexMapCellId> HexMapSpace::get_cell_ids_in_local_quad(Vector3 a,
     Vector2 bb(d[axis[0]], d[axis[1]]);
     Vector2 bc(c[axis[0]], c[axis[1]]);
 
-    // pull the vertices in towards the center make it easier to select SW/SE
-    // line
-    float scale = 1.0 - padding;
-    PackedVector3Array vertices =
-            get_cell_vertices(Vector3(scale, scale, scale));
+    // cell vertices (same order as get_cell_vertices()), pulled in towards
+    // the center to make it easier to select the SW/SE line
+    real_t scale = 1.0 - padding;
+    const Vector2 corners[6] = {
+        Vector2(0.0, -1.0),
+        Vector2(-Math_SQRT3_2, -0.5),
+        Vector2(-Math_SQRT3_2, 0.5),
+        Vector2(0.0, 1.0),
+        Vector2(Math_SQRT3_2, 0.5),
+        Vector2(Math_SQRT3_2, -0.5),
+    };
+    Vector3 verts[12];
+    for (int i = 0; i < 6; i++) {
+        verts[i] = Vector3(corners[i].x, 0.5, corners[i].y) * scale;
+        verts[i + 6] = Vector3(corners[i].x, -0.5, corners[i].y) * scale;
+    }
+
+    // A cell is selected when one of its points falls within the projected
+    // quad, and the plane passes through the cell.  The plane point above
+    // the point inside the quad is on the quad, and because the plane's
+    // slope along the normal axis is at most sqrt(2), it is no further than
+    // sqrt(2) * sqrt(5) (the widest projected cell) from the cell along that
+    // axis.  So only cells whose bounds, stretched by that much along the
+    // normal axis (and a little slack for rounding), touch the quad can be
+    // selected.  We walk those a hex row at a time, clipping the quad to
+    // each row to find the range of q.
+    Vector3 reach(0.01, 0.01, 0.01);
+    reach[normal_axis] = Math_SQRT2 * Math::sqrt(5.0) + 0.01;
+    const real_t cell_half_width = Math_SQRT3_2;
+    const real_t cell_half_depth = 1.0;
+
+    Vector3 quad_min = a.min(b).min(c).min(d);
+    Vector3 quad_max = a.max(b).max(c).max(d);
+    int y_min = Math::ceil(quad_min.y - 0.5 - reach.y);
+    int y_max = Math::floor(quad_max.y + 0.5 + reach.y);
+    int r_min = Math::ceil((quad_min.z - cell_half_depth - reach.z) / 1.5);
+    int r_max = Math::floor((quad_max.z + cell_half_depth + reach.z) / 1.5);
 
-    Geometry2D *geo = Geometry2D::get_singleton();
     Vector<HexMapCellId> out;
     auto prof = profiling_begin("selecting cells");
-    for (const HexMapCellId &cell_id : iter) {
-        Vector3 center = cell_id.unit_center();
-        Vector2 point(center[axis[0]], center[axis[1]]);
-
-        // we're checking to see if any vertex (or the center point) falls
-        // within the two-dimensional quad we reduced the search space to. If a
-        // no cell vertex or center point falls within the quad, then the cell
-        // cannot be within the selection region.
-        bool intersect_quad =
-                geo->point_is_inside_triangle(point, aa, ab, ac) ||
-                geo->point_is_inside_triangle(point, ba, bb, bc);
-
-        // We're checking to see if any line from the center of the cell to one
-        // of the vertices intersects the selection plane. If not, then the
-        // cell cannot be in the selection region.
-        bool intersect_plane = false;
-        bool above = plane.is_point_over(center);
-
-        for (Vector3 vert : vertices) {
-            vert += center;
-
-            if (!intersect_plane && plane.is_point_over(vert) != above) {
-                intersect_plane = true;
-            }
-
-            Vector2 point(vert[axis[0]], vert[axis[1]]);
-            if (!intersect_quad &&
-                    (geo->point_is_inside_triangle(point, aa, ab, ac) ||
-                            geo->point_is_inside_triangle(
-                                    point, ba, bb, bc))) {
-                intersect_quad = true;
+    for (int y = y_min; y <= y_max; y++) {
+        for (int r = r_min; r <= r_max; r++) {
+            // x range of the quad within this row of cells
+            Vector3 row_min(0, y - 0.5 - reach.y, 1.5 * r - 1 - reach.z);
+            Vector3 row_max(0, y + 0.5 + reach.y, 1.5 * r + 1 + reach.z);
+            real_t x_min = INFINITY, x_max = -INFINITY;
+            clip_triangle_x_range(a, b, c, row_min, row_max, x_min, x_max);
+            clip_triangle_x_range(a, d, c, row_min, row_max, x_min, x_max);
+            if (x_min > x_max) {
+                continue;
             }
 
-            if (intersect_plane && intersect_quad) {
-                out.push_back(cell_id);
-                break;
+            // cells whose x range overlaps the quad; the cell center is at
+            // x = sqrt(3) * (q + r/2)
+            x_min -= cell_half_width + reach.x;
+            x_max += cell_half_width + reach.x;
+            int q_min = Math::ceil(x_min / Math_SQRT3 - r * 0.5);
+            int q_max = Math::floor(x_max / Math_SQRT3 - r * 0.5);
+
+            for (int q = q_min; q <= q_max; q++) {
+                HexMapCellId cell_id(q, r, y);
+                if (!cell_id.in_bounds()) {
+                    continue;
+                }
+                Vector3 center = cell_id.unit_center();
+                Vector2 point(center[axis[0]], center[axis[1]]);
+
+                // we're checking to see if any vertex (or the center point)
+                // falls within the two-dimensional quad we reduced the
+                // search space to.  If no cell vertex or center point falls
+                // within the quad, then the cell cannot be within the
+                // selection region.
+                bool intersect_quad =
+                        point_in_triangle(point, aa, ab, ac) ||
+                        point_in_triangle(point, ba, bb, bc);
+
+                // We're checking to see if any line from the center of the
+                // cell to one of the vertices intersects the selection
+                // plane.  If not, then the cell cannot be in the selection
+                // region.
+                bool intersect_plane = false;
+                bool above = plane.is_point_over(center);
+
+                for (const Vector3 &offset : verts) {
+                    Vector3 vert = center + offset;
+
+                    if (!intersect_plane &&
+                            plane.is_point_over(vert) != above) {
+                        intersect_plane = true;
+                    }
+
+                    Vector2 point(vert[axis[0]], vert[axis[1]]);
+                    if (!intersect_quad &&
+                            (point_in_triangle(point, aa, ab, ac) ||
+                                    point_in_triangle(point, ba, bb, bc))) {
+                        intersect_quad = true;
+                    }
+
+                    if (intersect_plane && intersect_quad) {
+                        out.push_back(cell_id);
+                        break;
+                    }
+                }
             }
         }
     }
@@ -50,13 +50,19 @@ public:
         return global_transform.xform(cell.unit_center() * cell_scale);
     }
 
+    /// Get the transform for a given cell in local space
+    /// @param [offset] scaled offset from geometric center of cell
+    inline Transform3D get_cell_transform(const HexMapCellId &cell,
+            const Vector3 &offset = Vector3(0, 0, 0)) const {
+        return Transform3D(
+                Basis(), (cell.unit_center() + offset) * cell_scale);
+    }
+
     /// Get the transform for a given cell
     /// @param [offset] scaled offset from geometric center of cell
     inline Transform3D get_cell_transform_global(const HexMapCellId &cell,
             const Vector3 &offset = Vector3(0, 0, 0)) const {
-        Transform3D cell_transform(
-                Basis(), (cell.unit_center() + offset) * cell_scale);
-        return global_transform * cell_transform;
+        return global_transform * get_cell_transform(cell, offset);
     }
 
     /// Get the `HexMapCellId` for a point in local space
@@ -64,6 +70,24 @@ public:
         return HexMapCellId::from_unit_point(local_pos / cell_scale);
     }
 
+    /// Batch version of get_cell_id(); convert `count` points in local space
+    /// into cell ids.  Points are converted four at a time with SSE2 where
+    /// available, with the same result as get_cell_id().
+    void get_cell_ids(const Vector3 *local_points,
+            size_t count,
+            HexMapCellId *out) const;
+
+    /// get_cell_ids() writing cell keys; the caller must make sure the
+    /// points are within the 16-bit range of a key, or the coordinates wrap.
+    void get_cell_ids(const Vector3 *local_points,
+            size_t count,
+            HexMapCellId::Key *out) const;
+
+    /// Batch version of get_cell_center()
+    void get_cell_centers(const HexMapCellId::Key *cells,
+            size_t count,
+            Vector3 *out) const;
+
     /// Get the `HexMapCellId` for a point in global space
     inline HexMapCellId get_cell_id_global(const Vector3 &global_pos) const {
         Vector3 local = global_transform.inverse().xform(global_pos);
@@ -84,6 +108,9 @@ public:
     /// surface 0 contains the triangles, surface 1 contains the lines
     Ref<ArrayMesh> build_cell_mesh() const;
 
+    /// generate the cell mesh drawn in place of missing `MeshLibrary` items
+    Ref<ArrayMesh> build_placeholder_mesh() const;
+
     /// return the `HexMapCellId` of every cell within a quad in local space
     ///
     /// @param a quad vertex
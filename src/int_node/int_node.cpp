@@ -1,14 +1,62 @@
 #include <godot_cpp/classes/global_constants.hpp>
 #include <godot_cpp/core/error_macros.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
 #include <godot_cpp/variant/array.hpp>
 #include <godot_cpp/variant/dictionary.hpp>
 #include <godot_cpp/variant/packed_byte_array.hpp>
 #include <godot_cpp/variant/variant.hpp>
 
 #include "core/cell_id.h"
+#include "core/memory_usage.h"
 #include "core/tile_orientation.h"
 #include "int_node/int_node.h"
 
+// PackedByteArray::encode_*() & decode_*() are engine calls, which adds up
+// when made four times per cell; read & write the buffer directly instead.
+static _FORCE_INLINE_ void write_u16(uint8_t *out, uint16_t value) {
+    out[0] = value & 0xff;
+    out[1] = value >> 8;
+}
+
+static _FORCE_INLINE_ uint16_t read_u16(const uint8_t *buf) {
+    return buf[0] | (buf[1] << 8);
+}
+
+void HexMapIntNode::encode_cells(const CellMap &cells, uint8_t *out) {
+    // Write the cells in morton order so the output does not depend on the
+    // HashMap insertion history, and neighboring cells are stored together.
+    // The 48-bit morton code and 16-bit value pack into a single uint64_t.
+    LocalVector<uint64_t> sorted;
+    sorted.reserve(cells.size());
+    for (const auto &iter : cells) {
+        sorted.push_back((iter.key.to_morton() << 16) | iter.value);
+    }
+    sorted.sort();
+
+    for (uint64_t packed : sorted) {
+        HexMapCellId::Key key = HexMapCellId::Key::from_morton(packed >> 16);
+        write_u16(out, key.q);
+        write_u16(out + 2, key.r);
+        write_u16(out + 4, key.y);
+        write_u16(out + 6, packed & 0xffff);
+        out += ENCODED_CELL_SIZE;
+    }
+}
+
+void HexMapIntNode::decode_cells(const uint8_t *buf,
+        size_t size,
+        CellMap &cells) {
+    cells.reserve(cells.size() + size / ENCODED_CELL_SIZE);
+    for (const uint8_t *end = buf + size; buf < end;
+            buf += ENCODED_CELL_SIZE) {
+        HexMapCellId::Key key;
+        key.q = (int16_t)read_u16(buf);
+        key.r = (int16_t)read_u16(buf + 2);
+        key.y = (int16_t)read_u16(buf + 4);
+        cells.insert(key, read_u16(buf + 6));
+    }
+}
+
 void HexMapIntNode::_get_property_list(List<PropertyInfo> *p_list) const {
     p_list->push_back(PropertyInfo(Variant::ARRAY,
             "cell_types",
@@ -30,18 +78,8 @@ bool HexMapIntNode::_get(const StringName &p_name, Variant &r_ret) const {
         return true;
     } else if (name == "cells") {
         PackedByteArray cells;
-        cells.resize(cell_map.size() * 8);
-        size_t offset = 0;
-        for (const auto &iter : cell_map) {
-            cells.encode_s16(offset, iter.key.q);
-            offset += 2;
-            cells.encode_s16(offset, iter.key.r);
-            offset += 2;
-            cells.encode_s16(offset, iter.key.y);
-            offset += 2;
-            cells.encode_u16(offset, iter.value);
-            offset += 2;
-        }
+        cells.resize(cell_map.size() * ENCODED_CELL_SIZE);
+        encode_cells(cell_map, cells.ptrw());
         r_ret = cells;
         return true;
     }
@@ -63,24 +101,11 @@ bool HexMapIntNode::_set(const StringName &p_name, const Variant &p_value) {
         return true;
     } else if (name == "cells") {
         const PackedByteArray cells = p_value;
-        ERR_FAIL_COND_V_MSG(cells.size() % 8 != 0,
+        ERR_FAIL_COND_V_MSG(cells.size() % ENCODED_CELL_SIZE != 0,
                 false,
                 "HexMapIntNode cells PackedByteArray must be a multiple of 8");
-        size_t offset = 0, max = cells.size();
-        while (offset < max) {
-            HexMapCellId::Key key;
-            key.q = cells.decode_s16(offset);
-            offset += 2;
-            key.r = cells.decode_s16(offset);
-            offset += 2;
-            key.y = cells.decode_s16(offset);
-            offset += 2;
-
-            unsigned value = cells.decode_u16(offset);
-            offset += 2;
-
-            cell_map[key] = value;
-        }
+        decode_cells(cells.ptr(), cells.size(), cell_map);
+        cells_modified();
         return true;
     }
     return false;
@@ -160,6 +185,7 @@ void HexMapIntNode::set_cell(const HexMapCellId &cell_id,
     } else {
         ERR_FAIL_MSG("cell value must be in 0..65535");
     }
+    cells_modified();
 }
 
 HexMapNode::CellInfo HexMapIntNode::get_cell(
@@ -171,6 +197,13 @@ HexMapNode::CellInfo HexMapIntNode::get_cell(
     return CellInfo{ .value = *current_cell };
 }
 
+void HexMapIntNode::snapshot_cells(HexMapCellMap<CellInfo> &cells) const {
+    cells.reserve(cell_map.size());
+    for (const auto &iter : cell_map) {
+        cells.insert(iter.key, CellInfo{ .value = iter.value });
+    }
+}
+
 bool HexMapIntNode::has(HexMapCellId cell_id) const {
     return cell_map.has(cell_id);
 }
@@ -183,6 +216,19 @@ Array HexMapIntNode::get_cell_vecs() const {
     return out;
 }
 
+Dictionary HexMapIntNode::get_memory_usage() const {
+    Dictionary out;
+    size_t cells = ::get_memory_usage(cell_map);
+    size_t types = ::get_memory_usage(cell_types);
+    for (const auto &iter : cell_types) {
+        types += iter.value.name.length() * sizeof(char32_t);
+    }
+    out["cell_map"] = (int64_t)cells;
+    out["cell_types"] = (int64_t)types;
+    out["total"] = (int64_t)(cells + types);
+    return out;
+}
+
 Array HexMapIntNode::find_cell_vecs_by_value(int value) const {
     Array out;
     for (const auto &iter : cell_map) {
@@ -6,6 +6,7 @@
 #include <godot_cpp/variant/color.hpp>
 
 #include "core/cell_id.h"
+#include "core/cell_map.h"
 #include "core/hex_map_node.h"
 
 using namespace godot;
@@ -26,6 +27,18 @@ public:
         Color color;
     };
     using TypeMap = HashMap<unsigned, CellType>;
+    using CellMap = HexMapCellMap<uint16_t>;
+
+    /// bytes per cell in the serialized `cells` property
+    static const size_t ENCODED_CELL_SIZE = 8;
+
+    /// serialize cells as little-endian (q, r, y, value) int16 tuples
+    /// @param [out] must have room for `cells.size() * ENCODED_CELL_SIZE`
+    static void encode_cells(const CellMap &cells, uint8_t *out);
+
+    /// add the cells from a buffer written by encode_cells() to `cells`
+    /// @param [size] buffer size; must be a multiple of ENCODED_CELL_SIZE
+    static void decode_cells(const uint8_t *buf, size_t size, CellMap &cells);
 
     /// Argument to set_cell_type to have the cell type id assigned
     /// automatically
@@ -57,6 +70,7 @@ public:
     bool has(HexMapCellId) const override;
     Array get_cell_vecs() const override;
     Array find_cell_vecs_by_value(int value) const override;
+    Dictionary get_memory_usage() const override;
     void set_cell_visibility(const HexMapCellId &cell_id,
             bool visibility) override {};
 
@@ -67,8 +81,10 @@ protected:
     bool _get(const StringName &p_name, Variant &r_ret) const;
     bool _set(const StringName &p_name, const Variant &p_value);
 
+    void snapshot_cells(HexMapCellMap<CellInfo> &cells) const override;
+
 private:
     unsigned type_id_max;
     TypeMap cell_types;
-    HashMap<HexMapCellId::Key, uint16_t> cell_map;
+    CellMap cell_map;
 };
@@ -0,0 +1,94 @@
+#include <godot_cpp/classes/performance.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+#include <godot_cpp/variant/string_name.hpp>
+
+#include "auto_tiled_node/auto_tiled_node.h"
+#include "core/mesh_tool.h"
+#include "performance_monitors.h"
+#include "tiled_node/octant.h"
+#include "tiled_node/tiled_node.h"
+
+using namespace godot;
+
+static int64_t monitor_cells() { return HexMapTiledNode::monitor_cells.get(); }
+
+static int64_t monitor_octants() {
+    return HexMapOctant::monitor_octants.get();
+}
+
+static int64_t monitor_dirty_octants() {
+    return HexMapTiledNode::monitor_dirty_octants.get();
+}
+
+static double monitor_update_time() {
+    return HexMapTiledNode::monitor_update_usec.get() / 1000.0;
+}
+
+static int64_t monitor_multimeshes() {
+    return HexMapMeshTool::monitor_multimeshes.get();
+}
+
+static int64_t monitor_instances() {
+    return HexMapMeshTool::monitor_instances.get();
+}
+
+static int64_t monitor_physics_shapes() {
+    return HexMapOctant::monitor_physics_shapes.get();
+}
+
+static double monitor_apply_rules_time() {
+    return HexMapAutoTiledNode::monitor_apply_rules_usec.get() / 1000.0;
+}
+
+static int64_t monitor_cells_evaluated() {
+    return HexMapAutoTiledNode::monitor_cells_evaluated.get();
+}
+
+struct Monitor {
+    const char *id;
+    Callable callable;
+};
+
+static Vector<Monitor> get_monitors() {
+    // clang-format off
+    return {
+        { "HexMap/cells", callable_mp_static(&monitor_cells) },
+        { "HexMap/octants", callable_mp_static(&monitor_octants) },
+        { "HexMap/dirty_octants_updated",
+            callable_mp_static(&monitor_dirty_octants) },
+        { "HexMap/octant_update_time_ms",
+            callable_mp_static(&monitor_update_time) },
+        { "HexMap/multimeshes", callable_mp_static(&monitor_multimeshes) },
+        { "HexMap/multimesh_instances",
+            callable_mp_static(&monitor_instances) },
+        { "HexMap/physics_shapes",
+            callable_mp_static(&monitor_physics_shapes) },
+        { "HexMap/auto_tile_time_ms",
+            callable_mp_static(&monitor_apply_rules_time) },
+        { "HexMap/auto_tile_cells_evaluated",
+            callable_mp_static(&monitor_cells_evaluated) },
+    };
+    // clang-format on
+}
+
+void hexmap_add_performance_monitors() {
+    Performance *performance = Performance::get_singleton();
+    ERR_FAIL_NULL(performance);
+    for (const Monitor &monitor : get_monitors()) {
+        if (!performance->has_custom_monitor(monitor.id)) {
+            performance->add_custom_monitor(monitor.id, monitor.callable);
+        }
+    }
+}
+
+void hexmap_remove_performance_monitors() {
+    Performance *performance = Performance::get_singleton();
+    if (performance == nullptr) {
+        return;
+    }
+    for (const Monitor &monitor : get_monitors()) {
+        if (performance->has_custom_monitor(monitor.id)) {
+            performance->remove_custom_monitor(monitor.id);
+        }
+    }
+}
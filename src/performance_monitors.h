@@ -0,0 +1,9 @@
+#pragma once
+
+/// Add the HexMap custom monitors to the Performance singleton.  They are
+/// shown under "HexMap" in the debugger Monitors tab, and can be read with
+/// `Performance.get_custom_monitor("HexMap/cells")`.
+void hexmap_add_performance_monitors();
+
+/// Remove the HexMap custom monitors from the Performance singleton
+void hexmap_remove_performance_monitors();
@@ -1,8 +1,119 @@
 #include "profiling.h"
 
-#ifdef __APPLE__
+#if defined(HEXMAP_PROFILING_TRACE)
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+// Each thread records into its own fixed-size ring buffer, so recording a
+// zone never takes a lock.  Buffers are registered once per thread, and live
+// until the process exits so profiling_dump_trace() can read them after the
+// thread has finished.  When a buffer fills, the oldest entries are
+// overwritten.
+static constexpr size_t TRACE_BUFFER_SIZE = 1 << 16;
+
+struct TraceEntry {
+    const char *name;
+    uint64_t start;
+    // zero for instant events
+    uint64_t end;
+};
+
+struct TraceBuffer {
+    TraceEntry entries[TRACE_BUFFER_SIZE];
+    std::atomic<uint64_t> head{ 0 };
+    unsigned int thread_id;
+};
+
+static std::mutex trace_buffers_lock;
+static std::vector<TraceBuffer *> trace_buffers;
+
+static TraceBuffer *trace_buffer() {
+    thread_local TraceBuffer *buffer = nullptr;
+    if (unlikely(buffer == nullptr)) {
+        buffer = new TraceBuffer;
+        std::lock_guard<std::mutex> guard(trace_buffers_lock);
+        buffer->thread_id = trace_buffers.size();
+        trace_buffers.push_back(buffer);
+    }
+    return buffer;
+}
+
+static _FORCE_INLINE_ void trace_push(const char *name,
+        uint64_t start,
+        uint64_t end) {
+    TraceBuffer *buffer = trace_buffer();
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    buffer->entries[head % TRACE_BUFFER_SIZE] = TraceEntry{
+        .name = name,
+        .start = start,
+        .end = end,
+    };
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+uint64_t profiling_now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+void profiling_record_zone(const char *name, uint64_t start, uint64_t end) {
+    trace_push(name, start, end);
+}
+
+void profiling_record_event(const char *name) {
+    trace_push(name, profiling_now(), 0);
+}
+
+bool profiling_dump_trace(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(trace_buffers_lock);
+    fputs("{\"traceEvents\":[\n", file);
+    bool first = true;
+    for (const TraceBuffer *buffer : trace_buffers) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t tail =
+                head > TRACE_BUFFER_SIZE ? head - TRACE_BUFFER_SIZE : 0;
+        for (uint64_t i = tail; i < head; i++) {
+            const TraceEntry &entry = buffer->entries[i % TRACE_BUFFER_SIZE];
+            // trace-event timestamps are in microseconds
+            double ts = entry.start / 1000.0;
+            if (entry.end == 0) {
+                fprintf(file,
+                        "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\","
+                        "\"ts\":%.3f,\"pid\":0,\"tid\":%u}",
+                        first ? "" : ",\n",
+                        entry.name,
+                        ts,
+                        buffer->thread_id);
+            } else {
+                fprintf(file,
+                        "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,"
+                        "\"dur\":%.3f,\"pid\":0,\"tid\":%u}",
+                        first ? "" : ",\n",
+                        entry.name,
+                        ts,
+                        (entry.end - entry.start) / 1000.0,
+                        buffer->thread_id);
+            }
+            first = false;
+        }
+    }
+    fputs("\n]}\n", file);
+    return fclose(file) == 0;
+}
+
+#elif defined(__APPLE__) && !defined(HEXMAP_PROFILING_NONE)
 
 os_log_t profiling_os_log = os_log_create("org.godot.gdextension.hexmap",
         OS_LOG_CATEGORY_POINTS_OF_INTEREST);
 
-#endif // __APPLE__
+#endif
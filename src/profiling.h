@@ -2,7 +2,90 @@
 
 #include "godot_cpp/core/defs.hpp"
 
-#ifdef __APPLE__
+// The profiling backend is selected at build time with the scons `profiling`
+// option, which sets one of:
+//
+// - HEXMAP_PROFILING_TRACE: portable scoped timers, recorded per thread and
+//   written out as a Chrome trace-event JSON file by profiling_dump_trace()
+// - HEXMAP_PROFILING_TRACY: Tracy zones & messages
+// - HEXMAP_PROFILING_NONE: profiling disabled
+//
+// When none are set, Apple platforms use os_signpost, and profiling is
+// disabled everywhere else.
+//
+// Usage:
+//      auto profiler = profiling_begin("zone name");
+//      profiling_emit("event name");
+//
+// Zone and event names must be string literals.
+
+#if defined(HEXMAP_PROFILING_TRACE)
+
+#include <cstdint>
+
+/// current time in nanoseconds from a monotonic clock
+uint64_t profiling_now();
+
+/// record a completed zone in the calling thread's ring buffer
+void profiling_record_zone(const char *name, uint64_t start, uint64_t end);
+
+/// record an instant event in the calling thread's ring buffer
+void profiling_record_event(const char *name);
+
+/// write every recorded zone & event to a Chrome trace-event JSON file;
+/// load the file in chrome://tracing or https://ui.perfetto.dev
+bool profiling_dump_trace(const char *path);
+
+class ProfilingZone {
+    const char *name;
+    uint64_t start;
+
+public:
+    _FORCE_INLINE_ ProfilingZone(const char *name) :
+            name(name), start(profiling_now()) {}
+    _FORCE_INLINE_ ~ProfilingZone() {
+        profiling_record_zone(name, start, profiling_now());
+    }
+    ProfilingZone(const ProfilingZone &) = delete;
+    ProfilingZone &operator=(const ProfilingZone &) = delete;
+};
+
+#define profiling_begin(name, ...) ProfilingZone(name)
+#define profiling_emit(name, ...) profiling_record_event(name)
+
+#elif defined(HEXMAP_PROFILING_TRACY)
+
+#include <tracy/TracyC.h>
+#include <cstring>
+
+class ProfilingTracyZone {
+    TracyCZoneCtx ctx;
+
+public:
+    _FORCE_INLINE_ ProfilingTracyZone(const char *name,
+            const char *file,
+            uint32_t line,
+            const char *function) {
+        uint64_t srcloc = ___tracy_alloc_srcloc_name(line,
+                file,
+                strlen(file),
+                function,
+                strlen(function),
+                name,
+                strlen(name),
+                0);
+        ctx = ___tracy_emit_zone_begin_alloc(srcloc, 1);
+    }
+    _FORCE_INLINE_ ~ProfilingTracyZone() { ___tracy_emit_zone_end(ctx); }
+    ProfilingTracyZone(const ProfilingTracyZone &) = delete;
+    ProfilingTracyZone &operator=(const ProfilingTracyZone &) = delete;
+};
+
+#define profiling_begin(name, ...)                                            \
+    ProfilingTracyZone(name, __FILE__, __LINE__, __func__)
+#define profiling_emit(name, ...) TracyCMessage(name, strlen(name))
+
+#elif defined(__APPLE__) && !defined(HEXMAP_PROFILING_NONE)
 
 #include <os/log.h>
 #include <os/signpost.h>
@@ -46,4 +129,4 @@ public:
     do {                                                                      \
     } while (0)
 
-#endif // __APPLE__
+#endif
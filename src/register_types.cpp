@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <gdextension_interface.h>
 #include <godot_cpp/classes/editor_plugin.hpp>
 #include <godot_cpp/core/class_db.hpp>
@@ -7,11 +8,17 @@
 #include "auto_tiled_node/auto_tiled_node.h"
 #include "auto_tiled_node/editor/editor_plugin.h"
 #include "core/cell_id.h"
+#include "core/flow_field.h"
 #include "core/hex_map_node.h"
 #include "core/iter.h"
+#include "core/library_cache.h"
+#include "core/pathfinder.h"
+#include "core/snapshot.h"
 #include "godot_cpp/classes/navigation_server3d.hpp"
 #include "int_node/editor/editor_plugin.h"
 #include "int_node/int_node.h"
+#include "performance_monitors.h"
+#include "profiling.h"
 #include "tiled_node/editor/editor_plugin.h"
 #include "tiled_node/tiled_node.h"
 
@@ -22,11 +29,16 @@ void initialize_hexmap_module(ModuleInitializationLevel p_level) {
         ClassDB::register_class<hex_bind::HexMapCellId>();
         ClassDB::register_class<hex_bind::HexMapIter>();
         ClassDB::register_class<hex_bind::HexMapSpace>();
+        ClassDB::register_internal_class<HexMapLibraryCache>();
         ClassDB::register_abstract_class<HexMapNode>();
+        ClassDB::register_class<HexMapPathfinder>();
+        ClassDB::register_class<HexMapFlowField>();
+        ClassDB::register_class<HexMapSnapshot>();
         ClassDB::register_class<HexMapTiledNode>();
         ClassDB::register_class<HexMapIntNode>();
         ClassDB::register_class<HexMapAutoTiledNode>();
         ClassDB::register_class<HexMapAutoTiledNode::HexMapTileRule>();
+        hexmap_add_performance_monitors();
     }
 
 #ifdef TOOLS_ENABLED
@@ -57,6 +69,17 @@ void uninitialize_hexmap_module(ModuleInitializationLevel p_level) {
     if (p_level != MODULE_INITIALIZATION_LEVEL_SCENE) {
         return;
     }
+    hexmap_remove_performance_monitors();
+
+#if defined(HEXMAP_PROFILING_TRACE)
+    const char *trace_path = getenv("HEXMAP_PROFILING_TRACE_FILE");
+    if (trace_path == nullptr) {
+        trace_path = "hexmap_trace.json";
+    }
+    if (!profiling_dump_trace(trace_path)) {
+        ERR_PRINT(String("failed to write profiling trace to ") + trace_path);
+    }
+#endif
 }
 
 extern "C" {
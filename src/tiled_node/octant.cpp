@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <cassert>
 #include <godot_cpp/classes/array_mesh.hpp>
+#include <godot_cpp/classes/importer_mesh.hpp>
 #include <godot_cpp/classes/material.hpp>
 #include <godot_cpp/classes/mesh.hpp>
 #include <godot_cpp/classes/mesh_data_tool.hpp>
@@ -8,14 +10,15 @@
 #include <godot_cpp/classes/rendering_server.hpp>
 #include <godot_cpp/classes/scene_tree.hpp>
 #include <godot_cpp/classes/shape3d.hpp>
-#include <godot_cpp/classes/surface_tool.hpp>
 #include <godot_cpp/classes/world3d.hpp>
 #include <godot_cpp/core/error_macros.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
 #include <godot_cpp/templates/pair.hpp>
 #include <godot_cpp/templates/vector.hpp>
 #include <godot_cpp/variant/packed_vector3_array.hpp>
 #include <godot_cpp/variant/transform3d.hpp>
 
+#include "core/memory_usage.h"
 #include "octant.h"
 #include "profiling.h"
 #include "tiled_node.h"
@@ -35,22 +38,30 @@ void HexMapOctant::build_physics_body() {
             "should be only be called when HexMap is in SceneTree");
     RenderingServer *rs = RenderingServer::get_singleton();
     PhysicsServer3D *ps = PhysicsServer3D::get_singleton();
-    Ref<MeshLibrary> &mesh_library = hex_map.mesh_library;
+    Ref<HexMapLibraryCache> &library_cache = hex_map.library_cache;
 
     ps->body_clear_shapes(physics_body);
+    monitor_physics_shapes.sub(physics_shape_count);
+    physics_shape_count = 0;
 
     if (collision_debug_mesh.is_valid()) {
         rs->mesh_clear(collision_debug_mesh);
     }
 
     // can't do anything without the MeshLibrary
-    if (!mesh_library.is_valid()) {
+    if (!library_cache.is_valid()) {
         return;
     }
 
     // to update the collision debugging mesh, we need the vertices for all of
-    // the collision shapes
-    PackedVector3Array debug_mesh_vertices;
+    // the collision shapes; collect the cached shape vertices here, and
+    // transform them all at once after the loop.
+    struct DebugShape {
+        const PackedVector3Array *vertices;
+        Transform3D transform;
+    };
+    LocalVector<DebugShape> debug_shapes;
+    int64_t debug_vertex_count = 0;
 
     // get the mesh offset from the hexmap
     Vector3 mesh_offset = hex_map.get_mesh_origin_vec();
@@ -62,44 +73,39 @@ void HexMapOctant::build_physics_body() {
         const HexMapTiledNode::Cell *cell = hex_map.cell_map.getptr(cell_key);
         ERR_CONTINUE_MSG(cell == nullptr, "nonexistent HexMap cell in Octant");
 
-        Ref<Mesh> mesh = mesh_library->get_item_mesh(cell->value);
-        if (!mesh.is_valid()) {
+        const HexMapLibraryCache::Item *item =
+                library_cache->get_item(cell->value);
+        if (item == nullptr || !item->mesh_rid.is_valid()) {
             continue;
         }
-        RID mesh_rid = mesh->get_rid();
 
         Transform3D cell_transform(cell->get_basis(),
                 hex_map.get_cell_center(cell_key) + mesh_offset);
 
         // Update the static body for the octant if the mesh library has any
         // collision shapes for this cell type.  Note that the collision shape
-        // has its own transform independent of the mesh transform.  Also
-        // get_item_shapes() returns an array of Shape3D followed by
-        // Transform3D for each shape.
-        const Array shapes = mesh_library->get_item_shapes(cell->value);
-        for (int i = 0; i < shapes.size(); i += 2) {
-            Shape3D *shape = Object::cast_to<Shape3D>(shapes[i]);
-            Transform3D shape_transform =
-                    cell_transform * (Transform3D)shapes[i + 1];
+        // has its own transform independent of the mesh transform.
+        for (const HexMapLibraryCache::Shape &shape : item->shapes) {
+            Transform3D shape_transform = cell_transform * shape.transform;
 
             // add the shape to the physics body
-            ps->body_add_shape(
-                    physics_body, shape->get_rid(), shape_transform);
+            ps->body_add_shape(physics_body, shape.rid, shape_transform);
+            physics_shape_count++;
 
-            // if we have a collision debugging mesh, add the shape vertices to
-            // the vertex array.
+            // if we have a collision debugging mesh, save off the shape
+            // vertices for the debug mesh
             if (collision_debug_mesh.is_valid()) {
-                const Ref<ArrayMesh> &debug_mesh = shape->get_debug_mesh();
-                const Array arrays = debug_mesh->surface_get_arrays(0);
-                assert(arrays.size() > Mesh::ARRAY_VERTEX &&
-                        "arrays should include vertex arrays");
-                const PackedVector3Array vertices = arrays[Mesh::ARRAY_VERTEX];
-                for (const Vector3 &v : vertices) {
-                    debug_mesh_vertices.append(shape_transform.xform(v));
-                }
+                const PackedVector3Array &vertices =
+                        library_cache->get_shape_debug_vertices(shape);
+                debug_shapes.push_back(DebugShape{
+                        .vertices = &vertices,
+                        .transform = shape_transform,
+                });
+                debug_vertex_count += vertices.size();
             }
         }
     }
+    monitor_physics_shapes.add(physics_shape_count);
 
     Transform3D global_transform = hex_map.get_global_transform();
     ps->body_set_state(physics_body,
@@ -107,7 +113,21 @@ void HexMapOctant::build_physics_body() {
             global_transform);
 
     // update the collision debugging mesh if one exists
-    if (collision_debug_mesh.is_valid() && !debug_mesh_vertices.is_empty()) {
+    if (collision_debug_mesh.is_valid() && debug_vertex_count > 0) {
+        PackedVector3Array debug_mesh_vertices;
+        debug_mesh_vertices.resize(debug_vertex_count);
+        Vector3 *out = debug_mesh_vertices.ptrw();
+        for (const DebugShape &debug_shape : debug_shapes) {
+            const Basis &basis = debug_shape.transform.basis;
+            const Vector3 &origin = debug_shape.transform.origin;
+            const Vector3 *in = debug_shape.vertices->ptr();
+            const int64_t count = debug_shape.vertices->size();
+            for (int64_t i = 0; i < count; i++) {
+                out[i] = basis.xform(in[i]) + origin;
+            }
+            out += count;
+        }
+
         Array surface_arrays;
         surface_arrays.resize(RenderingServer::ARRAY_MAX);
         surface_arrays[RenderingServer::ARRAY_VERTEX] = debug_mesh_vertices;
@@ -122,56 +142,344 @@ void HexMapOctant::build_physics_body() {
     }
 }
 
-void HexMapOctant::bake_mesh() {
-    auto profiler = profiling_begin("Octant::bake_mesh()");
+// decode the triangle surfaces of a mesh into BakeSurface structs
+static Vector<HexMapOctant::BakeSurface> decode_bake_surfaces(
+        const Ref<Mesh> &mesh) {
+    Vector<HexMapOctant::BakeSurface> out;
+    if (!mesh.is_valid()) {
+        return out;
+    }
 
-    Ref<MeshLibrary> &mesh_library = hex_map.mesh_library;
-    HashMap<Ref<Material>, Ref<SurfaceTool>> mat_map;
+    for (int i = 0; i < mesh->get_surface_count(); i++) {
+        if (mesh->surface_get_primitive_type(i) !=
+                Mesh::PRIMITIVE_TRIANGLES) {
+            continue;
+        }
+        const Array arrays = mesh->surface_get_arrays(i);
+        ERR_CONTINUE(arrays.size() != Mesh::ARRAY_MAX);
+
+        HexMapOctant::BakeSurface surface;
+        surface.material = mesh->surface_get_material(i);
+        surface.vertices = arrays[Mesh::ARRAY_VERTEX];
+        surface.normals = arrays[Mesh::ARRAY_NORMAL];
+        surface.tangents = arrays[Mesh::ARRAY_TANGENT];
+        surface.colors = arrays[Mesh::ARRAY_COLOR];
+        surface.uvs = arrays[Mesh::ARRAY_TEX_UV];
+        surface.uv2s = arrays[Mesh::ARRAY_TEX_UV2];
+        surface.indices = arrays[Mesh::ARRAY_INDEX];
+        if (surface.vertices.is_empty()) {
+            continue;
+        }
+        out.push_back(surface);
+    }
 
-    // hide the mesh_manager; we want to preserve its state
-    mesh_tool.set_visible(false);
+    return out;
+}
+
+void HexMapOctant::prepare_bake(BakeJob &job,
+        BakeSurfaceCache &surface_cache) const {
+    auto profiler = profiling_begin("Octant::prepare_bake()");
+
+    const Ref<HexMapLibraryCache> &library_cache = hex_map.library_cache;
+    ERR_FAIL_COND(!library_cache.is_valid());
+
+    // index of the group for each material in job.groups
+    HashMap<Ref<Material>, int> material_groups;
 
     // get the mesh offset from the hexmap
     Vector3 mesh_offset = hex_map.get_mesh_origin_vec();
 
-    // iterate through the cells, add cell mesh surfaces to the surface tool
-    // for each material.
+    job.global_transform = hex_map.get_global_transform();
+
     for (const CellKey &cell_key : cells) {
         const HexMapTiledNode::Cell *cell = hex_map.cell_map.getptr(cell_key);
         ERR_CONTINUE_MSG(cell == nullptr, "nonexistent HexMap cell in Octant");
 
-        Ref<ArrayMesh> mesh = mesh_library->get_item_mesh(cell->value);
-        if (!mesh.is_valid()) {
+        // cells enclosed by their neighbors will never be seen
+        if (cell->occluded) {
+            continue;
+        }
+
+        const HexMapLibraryCache::Item *item =
+                library_cache->get_item(cell->value);
+        if (item == nullptr || !item->mesh.is_valid()) {
+            continue;
+        }
+
+        // look up the decoded surfaces for the cell item, decoding them if
+        // this is the first time we've seen this item.
+        const Vector<BakeSurface> *surfaces =
+                surface_cache.getptr(cell->value);
+        if (surfaces == nullptr) {
+            auto iter = surface_cache.insert(
+                    cell->value, decode_bake_surfaces(item->mesh));
+            surfaces = &iter->value;
+        }
+        if (surfaces->is_empty()) {
             continue;
         }
-        RID mesh_rid = mesh->get_rid();
 
         Transform3D transform;
         transform.basis = cell->get_basis();
         transform.set_origin(hex_map.get_cell_center(cell_key) + mesh_offset);
-        transform *= mesh_library->get_item_mesh_transform(cell->value);
+        transform *= item->mesh_transform;
+
+        for (const BakeSurface &surface : *surfaces) {
+            const int *group_index = material_groups.getptr(surface.material);
+            if (group_index == nullptr) {
+                auto iter = material_groups.insert(
+                        surface.material, job.groups.size());
+                group_index = &iter->value;
+                job.groups.push_back(BakeJob::Group{
+                        .material = surface.material });
+            }
+            job.groups.write[*group_index].instances.push_back(
+                    BakeJob::Instance{
+                            .surface = &surface,
+                            .transform = transform,
+                    });
+        }
+    }
+}
 
-        for (int i = 0; i < mesh->get_surface_count(); i++) {
-            if (mesh->surface_get_primitive_type(i) !=
-                    Mesh::PRIMITIVE_TRIANGLES) {
-                continue;
+void HexMapOctant::BakeJob::run() {
+    auto profiler = profiling_begin("Octant::BakeJob::run()");
+
+    // When generating LODs, the surfaces are assembled in an ImporterMesh,
+    // which can decimate them, and the ArrayMesh is pulled out at the end.
+    Ref<ImporterMesh> importer_mesh;
+    if (generate_lods) {
+        importer_mesh.instantiate();
+    } else {
+        mesh.instantiate();
+    }
+
+    for (const Group &group : groups) {
+        // Size the output arrays up front.  If any surface in the group has
+        // an optional array, we include it for the whole group, and fill in
+        // default values for those surfaces that don't have it.
+        int vertex_count = 0, index_count = 0;
+        bool has_normals = false, has_tangents = false, has_colors = false,
+             has_uvs = false, has_uv2s = false;
+        for (const Instance &instance : group.instances) {
+            const BakeSurface &surface = *instance.surface;
+            int count = surface.vertices.size();
+            vertex_count += count;
+            index_count += surface.indices.is_empty() ? count
+                                                      : surface.indices.size();
+            has_normals |= surface.normals.size() == count;
+            has_tangents |= surface.tangents.size() == count * 4;
+            has_colors |= surface.colors.size() == count;
+            has_uvs |= surface.uvs.size() == count;
+            has_uv2s |= surface.uv2s.size() == count;
+        }
+        if (vertex_count == 0) {
+            continue;
+        }
+
+        PackedVector3Array vertices, normals;
+        PackedFloat32Array tangents;
+        PackedColorArray colors;
+        PackedVector2Array uvs, uv2s;
+        PackedInt32Array indices;
+
+        vertices.resize(vertex_count);
+        indices.resize(index_count);
+        Vector3 *vertex_w = vertices.ptrw();
+        int32_t *index_w = indices.ptrw();
+        Vector3 *normal_w = nullptr;
+        float *tangent_w = nullptr;
+        Color *color_w = nullptr;
+        Vector2 *uv_w = nullptr, *uv2_w = nullptr;
+        if (has_normals) {
+            normals.resize(vertex_count);
+            normal_w = normals.ptrw();
+        }
+        if (has_tangents) {
+            tangents.resize(vertex_count * 4);
+            tangent_w = tangents.ptrw();
+        }
+        if (has_colors) {
+            colors.resize(vertex_count);
+            color_w = colors.ptrw();
+        }
+        if (has_uvs) {
+            uvs.resize(vertex_count);
+            uv_w = uvs.ptrw();
+        }
+        if (has_uv2s) {
+            uv2s.resize(vertex_count);
+            uv2_w = uv2s.ptrw();
+        }
+
+        // Concatenate the arrays for each cell, transforming the vertices,
+        // normals & tangents into octant space, and offsetting the indices.
+        int vertex_base = 0, index_base = 0;
+        for (const Instance &instance : group.instances) {
+            const BakeSurface &surface = *instance.surface;
+            const Transform3D &transform = instance.transform;
+            const Basis normal_basis = transform.basis.inverse().transposed();
+            const int count = surface.vertices.size();
+
+            const Vector3 *vertex_r = surface.vertices.ptr();
+            for (int i = 0; i < count; i++) {
+                vertex_w[vertex_base + i] = transform.xform(vertex_r[i]);
+            }
+
+            if (has_normals) {
+                if (surface.normals.size() == count) {
+                    const Vector3 *normal_r = surface.normals.ptr();
+                    for (int i = 0; i < count; i++) {
+                        normal_w[vertex_base + i] =
+                                normal_basis.xform(normal_r[i]).normalized();
+                    }
+                } else {
+                    for (int i = 0; i < count; i++) {
+                        normal_w[vertex_base + i] = Vector3();
+                    }
+                }
+            }
+
+            if (has_tangents) {
+                float *out = tangent_w + vertex_base * 4;
+                if (surface.tangents.size() == count * 4) {
+                    const float *tangent_r = surface.tangents.ptr();
+                    for (int i = 0; i < count; i++) {
+                        const float *in = tangent_r + i * 4;
+                        Vector3 tangent = transform.basis
+                                                  .xform(Vector3(in[0],
+                                                          in[1],
+                                                          in[2]))
+                                                  .normalized();
+                        out[i * 4 + 0] = tangent.x;
+                        out[i * 4 + 1] = tangent.y;
+                        out[i * 4 + 2] = tangent.z;
+                        out[i * 4 + 3] = in[3];
+                    }
+                } else {
+                    for (int i = 0; i < count * 4; i++) {
+                        out[i] = 0;
+                    }
+                }
             }
-            Ref<Material> material = mesh->surface_get_material(i);
-            Ref<SurfaceTool> *surface_tool = mat_map.getptr(material);
-            if (surface_tool == nullptr) {
-                auto iter = mat_map.insert(material, Ref<SurfaceTool>());
-                surface_tool = &iter->value;
-                surface_tool->instantiate();
-                surface_tool->ptr()->begin(Mesh::PRIMITIVE_TRIANGLES);
-                surface_tool->ptr()->set_material(material);
+
+            if (has_colors) {
+                bool present = surface.colors.size() == count;
+                const Color *color_r = surface.colors.ptr();
+                for (int i = 0; i < count; i++) {
+                    color_w[vertex_base + i] =
+                            present ? color_r[i] : Color(1, 1, 1, 1);
+                }
             }
-            surface_tool->ptr()->append_from(mesh, i, transform);
+
+            if (has_uvs) {
+                bool present = surface.uvs.size() == count;
+                const Vector2 *uv_r = surface.uvs.ptr();
+                for (int i = 0; i < count; i++) {
+                    uv_w[vertex_base + i] = present ? uv_r[i] : Vector2();
+                }
+            }
+
+            if (has_uv2s) {
+                bool present = surface.uv2s.size() == count;
+                const Vector2 *uv2_r = surface.uv2s.ptr();
+                for (int i = 0; i < count; i++) {
+                    uv2_w[vertex_base + i] = present ? uv2_r[i] : Vector2();
+                }
+            }
+
+            // A mirroring transform would turn the triangles inside-out, so
+            // swap the winding order to compensate.
+            bool flip = transform.basis.determinant() < 0;
+            if (surface.indices.is_empty()) {
+                for (int i = 0; i < count; i++) {
+                    index_w[index_base + i] = vertex_base + i;
+                }
+                if (flip) {
+                    for (int i = 0; i + 2 < count; i += 3) {
+                        SWAP(index_w[index_base + i + 1],
+                                index_w[index_base + i + 2]);
+                    }
+                }
+                index_base += count;
+            } else {
+                const int32_t *index_r = surface.indices.ptr();
+                int size = surface.indices.size();
+                for (int i = 0; i < size; i++) {
+                    index_w[index_base + i] = vertex_base + index_r[i];
+                }
+                if (flip) {
+                    for (int i = 0; i + 2 < size; i += 3) {
+                        SWAP(index_w[index_base + i + 1],
+                                index_w[index_base + i + 2]);
+                    }
+                }
+                index_base += size;
+            }
+
+            vertex_base += count;
         }
+
+        Array arrays;
+        arrays.resize(Mesh::ARRAY_MAX);
+        arrays[Mesh::ARRAY_VERTEX] = vertices;
+        arrays[Mesh::ARRAY_INDEX] = indices;
+        if (has_normals) {
+            arrays[Mesh::ARRAY_NORMAL] = normals;
+        }
+        if (has_tangents) {
+            arrays[Mesh::ARRAY_TANGENT] = tangents;
+        }
+        if (has_colors) {
+            arrays[Mesh::ARRAY_COLOR] = colors;
+        }
+        if (has_uvs) {
+            arrays[Mesh::ARRAY_TEX_UV] = uvs;
+        }
+        if (has_uv2s) {
+            arrays[Mesh::ARRAY_TEX_UV2] = uv2s;
+        }
+
+        if (importer_mesh.is_valid()) {
+            importer_mesh->add_surface(Mesh::PRIMITIVE_TRIANGLES,
+                    arrays,
+                    Array(),
+                    Dictionary(),
+                    group.material);
+        } else {
+            mesh->add_surface_from_arrays(Mesh::PRIMITIVE_TRIANGLES, arrays);
+            mesh->surface_set_material(
+                    mesh->get_surface_count() - 1, group.material);
+        }
+    }
+
+    if (importer_mesh.is_valid()) {
+        auto profiler = profiling_begin("Octant::BakeJob::generate_lods()");
+        if (importer_mesh->get_surface_count() > 0) {
+            importer_mesh->generate_lods(25, 60, Array());
+        }
+        mesh = importer_mesh->get_mesh();
     }
 
-    baked_mesh.instantiate();
-    for (const auto &it : mat_map) {
-        it.value->commit(baked_mesh);
+    // XXX texel size not easily modified for gridmap; do we need to expose
+    // this value or fetch it from someplace?  Also not sure about global
+    // transform here, but it matches GridMap
+    if (gen_lightmap_uv && mesh->get_surface_count() > 0) {
+        auto profiler = profiling_begin("Octant::BakeJob::lightmap_unwrap()");
+        mesh->lightmap_unwrap(global_transform, lightmap_uv_texel_size);
+    }
+}
+
+void HexMapOctant::commit_bake(const BakeJob &job) {
+    free_baked_mesh();
+    baked_mesh = job.mesh;
+
+    // hide the mesh_manager; we want to preserve its state
+    mesh_tool.set_visible(false);
+
+    if (!hex_map.is_inside_tree()) {
+        // instance will be created by apply_changes() when we enter the world
+        return;
     }
 
     RenderingServer *rs = RenderingServer::get_singleton();
@@ -182,12 +490,152 @@ void HexMapOctant::bake_mesh() {
             baked_mesh_instance, hex_map.get_instance_id());
     rs->instance_set_transform(
             baked_mesh_instance, hex_map.get_global_transform());
+    update_visibility_range();
+}
 
-    // XXX texel size not easily modified for gridmap; do we need to expose
-    // this value or fetch it from someplace?  Also not sure about global
-    // transform here, but it matches GridMap
+void HexMapOctant::bake_mesh() {
+    auto profiler = profiling_begin("Octant::bake_mesh()");
 
-    baked_mesh->lightmap_unwrap(hex_map.get_global_transform(), 0.1);
+    BakeSurfaceCache surface_cache;
+    BakeJob job;
+    job.gen_lightmap_uv = true;
+    prepare_bake(job, surface_cache);
+    job.run();
+    commit_bake(job);
+}
+
+void HexMapOctant::update_navigation_geometry(
+        BakeSurfaceCache &surface_cache) {
+    if (!navigation_dirty) {
+        return;
+    }
+    auto profiler = profiling_begin("Octant::update_navigation_geometry()");
+
+    navigation_dirty = false;
+    navigation_vertices.clear();
+    navigation_indices.clear();
+
+    const Ref<HexMapLibraryCache> &library_cache = hex_map.library_cache;
+    if (!library_cache.is_valid()) {
+        return;
+    }
+
+    // calculate the mesh origin offset for each cell; this allows us to put
+    // the origin at the bottom or top of the cell, instead of the center.
+    Vector3 mesh_origin_offset = hex_map.get_mesh_origin_vec() *
+            hex_map.get_space().get_cell_scale();
+
+    // collect the surfaces & transforms for every cell first so we can size
+    // the output arrays up front.
+    struct Instance {
+        const PackedVector3Array *vertices;
+        /// empty for non-indexed surfaces
+        const PackedInt32Array *indices;
+        Transform3D transform;
+    };
+    LocalVector<Instance> instances;
+    int vertex_count = 0, index_count = 0;
+
+    for (const CellKey &cell_key : cells) {
+        const HexMapTiledNode::Cell *cell = hex_map.cell_map.getptr(cell_key);
+        ERR_CONTINUE_MSG(cell == nullptr, "nonexistent HexMap cell in Octant");
+
+        const HexMapLibraryCache::Item *item =
+                library_cache->get_item(cell->value);
+        if (item == nullptr) {
+            continue;
+        }
+
+        if (hex_map.navigation_bake_only_navmesh_tiles) {
+            // If there's a tile in the cell above this one, do not include
+            // this tile, otherwise when a navigable mesh has a
+            // non-navigable on top, the nav mesh incorrectly cuts through
+            // that upper tile.
+            if (cell_key.y < SHRT_MAX &&
+                    hex_map.cell_map.has(cell_key.get_cell_above())) {
+                continue;
+            }
+
+            // if the cell doesn't have a navmesh, skip it
+            if (!item->has_navigation_mesh) {
+                continue;
+            }
+        }
+
+        Transform3D cell_transform(cell->get_basis(),
+                hex_map.get_cell_center(cell_key) + mesh_origin_offset);
+
+        // use the simplified geometry from the item navigation mesh in
+        // place of the render mesh
+        if (hex_map.navigation_use_item_navmesh) {
+            if (item->navigation_indices.is_empty()) {
+                continue;
+            }
+            instances.push_back(Instance{
+                    .vertices = &item->navigation_vertices,
+                    .indices = &item->navigation_indices,
+                    .transform =
+                            cell_transform * item->navigation_mesh_transform,
+            });
+            vertex_count += item->navigation_vertices.size();
+            index_count += item->navigation_indices.size();
+            continue;
+        }
+
+        if (!item->mesh.is_valid()) {
+            continue;
+        }
+        const Vector<BakeSurface> *surfaces =
+                surface_cache.getptr(cell->value);
+        if (surfaces == nullptr) {
+            auto iter = surface_cache.insert(
+                    cell->value, decode_bake_surfaces(item->mesh));
+            surfaces = &iter->value;
+        }
+
+        Transform3D transform = cell_transform * item->mesh_transform;
+        for (const BakeSurface &surface : *surfaces) {
+            instances.push_back(Instance{
+                    .vertices = &surface.vertices,
+                    .indices = &surface.indices,
+                    .transform = transform,
+            });
+            int count = surface.vertices.size();
+            vertex_count += count;
+            index_count += surface.indices.is_empty() ? count
+                                                      : surface.indices.size();
+        }
+    }
+
+    navigation_vertices.resize(vertex_count);
+    navigation_indices.resize(index_count);
+    Vector3 *vertex_w = navigation_vertices.ptrw();
+    int32_t *index_w = navigation_indices.ptrw();
+
+    int vertex_base = 0, index_base = 0;
+    for (const Instance &instance : instances) {
+        const int count = instance.vertices->size();
+
+        const Vector3 *vertex_r = instance.vertices->ptr();
+        for (int i = 0; i < count; i++) {
+            vertex_w[vertex_base + i] = instance.transform.xform(vertex_r[i]);
+        }
+
+        if (instance.indices->is_empty()) {
+            for (int i = 0; i < count; i++) {
+                index_w[index_base + i] = vertex_base + i;
+            }
+            index_base += count;
+        } else {
+            const int32_t *index_r = instance.indices->ptr();
+            int size = instance.indices->size();
+            for (int i = 0; i < size; i++) {
+                index_w[index_base + i] = vertex_base + index_r[i];
+            }
+            index_base += size;
+        }
+        vertex_base += count;
+    }
 }
 
 void HexMapOctant::update_collision_properties() {
@@ -220,6 +668,111 @@ void HexMapOctant::update_visibility() {
     if (baked_mesh_instance.is_valid()) {
         rs->instance_set_visible(baked_mesh_instance, visible);
     }
+    if (far_mesh_instance.is_valid()) {
+        rs->instance_set_visible(far_mesh_instance, visible);
+    }
+}
+
+void HexMapOctant::update_visibility_range() {
+    RenderingServer *rs = RenderingServer::get_singleton();
+
+    // Once we have a far mesh, the near meshes are only drawn up to the far
+    // mesh distance.  Until then we keep drawing the near meshes at every
+    // distance so the octant doesn't disappear while the far mesh is built.
+    //
+    // The far mesh distance is clamped to the end of the visibility range, so
+    // the ranges are never inverted.  When the range ends first, the far mesh
+    // is never drawn.
+    real_t range_end = hex_map.lod_visibility_range_end;
+    real_t far_begin = hex_map.lod_far_mesh_distance;
+    if (range_end > 0 && far_begin > range_end) {
+        far_begin = range_end;
+    }
+    real_t near_end = range_end;
+    if (far_mesh_instance.is_valid()) {
+        near_end = far_begin;
+    }
+
+    mesh_tool.set_visibility_range(
+            hex_map.lod_visibility_range_begin, near_end);
+    if (baked_mesh_instance.is_valid()) {
+        rs->instance_geometry_set_visibility_range(baked_mesh_instance,
+                hex_map.lod_visibility_range_begin,
+                near_end,
+                0,
+                0,
+                RenderingServer::VISIBILITY_RANGE_FADE_DISABLED);
+    }
+    if (far_mesh_instance.is_valid()) {
+        rs->instance_geometry_set_visibility_range(far_mesh_instance,
+                far_begin,
+                range_end,
+                0,
+                0,
+                RenderingServer::VISIBILITY_RANGE_FADE_DISABLED);
+    }
+}
+
+void HexMapOctant::create_far_mesh_instance() {
+    if (!far_mesh.is_valid() || !hex_map.is_inside_tree()) {
+        return;
+    }
+
+    RenderingServer *rs = RenderingServer::get_singleton();
+    far_mesh_instance = rs->instance_create2(
+            far_mesh->get_rid(), hex_map.get_world_3d()->get_scenario());
+    rs->instance_attach_object_instance_id(
+            far_mesh_instance, hex_map.get_instance_id());
+    rs->instance_set_transform(
+            far_mesh_instance, hex_map.get_global_transform());
+    rs->instance_set_visible(far_mesh_instance, hex_map.is_visible_in_tree());
+}
+
+void HexMapOctant::free_far_mesh_instance() {
+    if (far_mesh_instance.is_valid()) {
+        RenderingServer::get_singleton()->free_rid(far_mesh_instance);
+        far_mesh_instance = RID();
+    }
+}
+
+void HexMapOctant::set_far_mesh(const Ref<ArrayMesh> &mesh,
+        uint32_t mesh_revision) {
+    free_far_mesh_instance();
+    far_mesh = mesh;
+    far_mesh_revision = mesh_revision;
+    create_far_mesh_instance();
+    update_visibility_range();
+}
+
+void HexMapOctant::clear_far_mesh() {
+    free_far_mesh_instance();
+    far_mesh = Ref<ArrayMesh>();
+    far_mesh_revision = UINT32_MAX;
+    update_visibility_range();
+}
+
+void HexMapOctant::update_transform() {
+    RenderingServer *rs = RenderingServer::get_singleton();
+    PhysicsServer3D *ps = PhysicsServer3D::get_singleton();
+
+    // The physics shapes, collision debug mesh, baked mesh, and multimesh
+    // instance transforms are all in local space; only the global
+    // transform of each instance needs to be updated.
+    Transform3D global_transform = hex_map.get_global_transform();
+    ps->body_set_state(physics_body,
+            PhysicsServer3D::BODY_STATE_TRANSFORM,
+            global_transform);
+    if (collision_debug_mesh_instance.is_valid()) {
+        rs->instance_set_transform(
+                collision_debug_mesh_instance, global_transform);
+    }
+    if (baked_mesh_instance.is_valid()) {
+        rs->instance_set_transform(baked_mesh_instance, global_transform);
+    }
+    if (far_mesh_instance.is_valid()) {
+        rs->instance_set_transform(far_mesh_instance, global_transform);
+    }
+    mesh_tool.set_transform(hex_map.get_space().get_transform());
 }
 
 void HexMapOctant::enter_world() {
@@ -244,6 +797,7 @@ void HexMapOctant::enter_world() {
                 collision_debug_mesh, hex_map.get_world_3d()->get_scenario());
     }
 
+    create_far_mesh_instance();
     apply_changes();
 }
 
@@ -254,6 +808,7 @@ void HexMapOctant::exit_world() {
     ps->body_set_space(physics_body, RID());
 
     mesh_tool.exit_world();
+    free_far_mesh_instance();
 
     if (baked_mesh_instance.is_valid()) {
         rs->free_rid(baked_mesh_instance);
@@ -292,47 +847,181 @@ void HexMapOctant::apply_changes() {
                 baked_mesh_instance, hex_map.get_instance_id());
         rs->instance_set_transform(
                 baked_mesh_instance, hex_map.get_global_transform());
+        update_visibility_range();
         return;
     }
     dirty = false;
 
     mesh_tool.set_space(hex_map.get_space());
-    mesh_tool.set_mesh_origin(hex_map.get_mesh_origin_vec());
-    Ref<MeshLibrary> mesh_library = hex_map.get_mesh_library();
-    mesh_tool.set_mesh_library(mesh_library);
-    mesh_tool.refresh();
+    mesh_tool.set_custom_data_format(
+            (HexMapMeshTool::CustomDataFormat)hex_map.custom_data_format);
+    update_visibility_range();
+    build_multimeshes();
 }
 
-void HexMapOctant::set_cell(const CellKey cell_key,
-        int index,
-        HexMapTileOrientation orientation) {
+void HexMapOctant::build_multimeshes() {
+    auto profiler = profiling_begin("HexMapOctant::build_multimeshes()");
+
+    const HexMapSpace &space = hex_map.get_space();
+    const Ref<HexMapLibraryCache> &library_cache = hex_map.library_cache;
+    Vector3 cell_scale = space.get_cell_scale();
+    Vector3 mesh_origin = hex_map.get_mesh_origin_vec();
+    bool custom_data =
+            hex_map.custom_data_format != HexMapTiledNode::CUSTOM_DATA_NONE;
+
+    // placeholder for cells whose item has no mesh; scaled to fill the cell
+    RID placeholder = hex_map.get_placeholder_mesh()->get_rid();
+    Transform3D placeholder_transform(
+            Basis::from_scale(cell_scale), -mesh_origin * cell_scale);
+
+    // The instance transforms are derived from the cell value & orientation
+    // here instead of being stored per cell; they're only needed to fill the
+    // multimesh buffers.
+    LocalVector<HexMapMeshTool::Instance> instances;
+    LocalVector<uint32_t> instance_cells;
+    instances.reserve(cells.size());
+    instance_cells.reserve(cells.size());
+    for (uint32_t i = 0; i < cells.size(); i++) {
+        const HexMapTiledNode::Cell *cell = hex_map.cell_map.getptr(cells[i]);
+        ERR_CONTINUE_MSG(cell == nullptr, "nonexistent HexMap cell in Octant");
+
+        // skip hidden & occluded cells
+        if (!cell->visible || cell->occluded) {
+            continue;
+        }
+
+        const HexMapLibraryCache::Item *item = nullptr;
+        if (library_cache.is_valid()) {
+            item = library_cache->get_item(cell->value);
+        }
+        RID mesh = placeholder;
+        Transform3D mesh_transform = placeholder_transform;
+        if (item != nullptr && item->mesh_rid.is_valid()) {
+            mesh = item->mesh_rid;
+            mesh_transform = item->mesh_transform;
+        }
+
+        HexMapCellId cell_id(cells[i]);
+        Transform3D cell_transform =
+                space.get_cell_transform(cell_id, mesh_origin * cell_scale) *
+                Transform3D(cell->get_basis());
+
+        instances.push_back(HexMapMeshTool::Instance{
+                .mesh = mesh,
+                .transform = cell_transform * mesh_transform,
+                .custom_data = custom_data
+                        ? hex_map.get_cell_custom_data(cell_id)
+                        : Color(1, 1, 1, 1),
+        });
+        instance_cells.push_back(i);
+    }
+
+    LocalVector<HexMapMeshTool::InstanceSlot> slots;
+    mesh_tool.build_instances(instances, slots);
+
+    // only keep the instance slots if custom data may be patched later
+    cell_slots.clear();
+    if (custom_data) {
+        cell_slots.resize(cells.size());
+        for (uint32_t i = 0; i < instance_cells.size(); i++) {
+            cell_slots[instance_cells[i]] = slots[i];
+        }
+    }
+}
+
+uint32_t HexMapOctant::find_cell(const CellKey cell_key) const {
+    uint64_t code = cell_key.to_morton();
+    uint32_t low = 0, high = cells.size();
+    while (low < high) {
+        uint32_t mid = (low + high) / 2;
+        if (cells[mid].to_morton() < code) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+bool HexMapOctant::has_cell(const CellKey cell_key) const {
+    uint32_t index = find_cell(cell_key);
+    return index < cells.size() && cells[index] == cell_key;
+}
+
+void HexMapOctant::set_cell(const CellKey cell_key) {
     free_baked_mesh();
-    cells.insert(cell_key);
-    mesh_tool.set_cell(cell_key, index, orientation);
-    dirty = true;
+    uint32_t index = find_cell(cell_key);
+    if (index == cells.size() || cells[index] != cell_key) {
+        cells.insert(index, cell_key);
+        cell_slots.clear();
+    }
+    set_dirty();
+}
+
+void HexMapOctant::sort_cells() {
+    std::sort(cells.ptr(),
+            cells.ptr() + cells.size(),
+            [](const CellKey &a, const CellKey &b) {
+                return a.to_morton() < b.to_morton();
+            });
+    cell_slots.clear();
+    set_dirty();
 }
 
 void HexMapOctant::clear_cell(const CellKey cell_key) {
     free_baked_mesh();
-    cells.erase(cell_key);
-    mesh_tool.clear_cell(cell_key);
-    dirty = true;
+    uint32_t index = find_cell(cell_key);
+    if (index < cells.size() && cells[index] == cell_key) {
+        cells.remove_at(index);
+        cell_slots.clear();
+    }
+    set_dirty();
 }
 
-void HexMapOctant::set_cell_visibility(HexMapCellId cell_id, bool visible) {
+void HexMapOctant::update_cell_visibility(const CellKey cell_key) {
     // nothing to be done if we have no value set for this cell
-    if (!cells.has(cell_id)) {
+    if (!has_cell(cell_key)) {
         return;
     }
     free_baked_mesh();
-    mesh_tool.set_cell_visibility(cell_id, visible);
-    dirty = true;
+    set_dirty();
+}
+
+void HexMapOctant::set_cell_custom_data(const CellKey cell_key,
+        const Color &value) {
+    // if the slots are missing, the cells were modified and the octant will
+    // pick up the new value when it is rebuilt.
+    uint32_t index = find_cell(cell_key);
+    if (index < cell_slots.size() && cells[index] == cell_key) {
+        mesh_tool.set_instance_custom_data(cell_slots[index], value);
+    }
+}
+
+void HexMapOctant::set_cells_custom_data(
+        const Vector<Pair<CellKey, Color>> &values) {
+    if (cell_slots.is_empty()) {
+        return;
+    }
+    LocalVector<Pair<HexMapMeshTool::InstanceSlot, Color>> instances;
+    instances.reserve(values.size());
+    for (const auto &pair : values) {
+        uint32_t index = find_cell(pair.first);
+        if (index < cell_slots.size() && cells[index] == pair.first) {
+            instances.push_back({ cell_slots[index], pair.second });
+        }
+    }
+    mesh_tool.set_instances_custom_data(instances);
 }
 
 void HexMapOctant::set_all_cells_visible() {
     free_baked_mesh();
-    mesh_tool.set_all_cells_visible();
-    dirty = true;
+    for (const CellKey &cell_key : cells) {
+        HexMapTiledNode::Cell *cell = hex_map.cell_map.getptr(cell_key);
+        if (cell != nullptr) {
+            cell->visible = true;
+        }
+    }
+    set_dirty();
 }
 
 void HexMapOctant::set_baked_mesh(Ref<Mesh> mesh) { baked_mesh = mesh; }
@@ -364,7 +1053,22 @@ void HexMapOctant::clear_baked_mesh() {
     }
 }
 
+void HexMapOctant::add_memory_usage(MemoryUsage &usage) const {
+    usage.octant_cells += cells.size() * sizeof(CellKey) +
+            cell_slots.size() * sizeof(HexMapMeshTool::InstanceSlot);
+    usage.multimesh_buffers += mesh_tool.get_multimesh_buffer_size();
+    usage.multimesh_buffer_copies +=
+            mesh_tool.get_multimesh_buffer_copy_size();
+    usage.navigation_geometry +=
+            navigation_vertices.size() * sizeof(Vector3) +
+            navigation_indices.size() * sizeof(int32_t);
+}
+
+SafeNumeric<int64_t> HexMapOctant::monitor_octants;
+SafeNumeric<int64_t> HexMapOctant::monitor_physics_shapes;
+
 HexMapOctant::HexMapOctant(HexMapTiledNode &hex_map) : hex_map(hex_map) {
+    monitor_octants.increment();
     PhysicsServer3D *ps = PhysicsServer3D::get_singleton();
 
     mesh_tool.set_object_id(hex_map.get_instance_id());
@@ -380,4 +1084,7 @@ HexMapOctant::HexMapOctant(HexMapTiledNode &hex_map) : hex_map(hex_map) {
 HexMapOctant::~HexMapOctant() {
     PhysicsServer3D *ps = PhysicsServer3D::get_singleton();
     ps->free_rid(physics_body);
+    free_far_mesh_instance();
+    monitor_physics_shapes.sub(physics_shape_count);
+    monitor_octants.decrement();
 }
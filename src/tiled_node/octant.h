@@ -1,14 +1,22 @@
 #pragma once
 
 #include <godot_cpp/classes/array_mesh.hpp>
+#include <godot_cpp/classes/material.hpp>
 #include <godot_cpp/classes/mesh.hpp>
 #include <godot_cpp/core/defs.hpp>
-#include <godot_cpp/templates/hash_set.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/templates/safe_refcount.hpp>
 #include <godot_cpp/templates/vector.hpp>
+#include <godot_cpp/variant/packed_color_array.hpp>
+#include <godot_cpp/variant/packed_float32_array.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+#include <godot_cpp/variant/packed_vector2_array.hpp>
+#include <godot_cpp/variant/packed_vector3_array.hpp>
 #include <godot_cpp/variant/rid.hpp>
 
 #include "core/cell_id.h"
-#include "core/library_mesh_tool.h"
+#include "core/mesh_tool.h"
 #include "core/tile_orientation.h"
 
 using namespace godot;
@@ -26,21 +34,55 @@ private:
     };
 
     HexMapTiledNode &hex_map;
-    HashSet<CellKey> cells;
 
-    HexMapLibraryMeshTool mesh_tool;
+    // Cells in the octant, sorted by morton code so that iterating the cells
+    // walks the octant in spatial order.  The value, orientation, and flags
+    // for each cell live in HexMapTiledNode::cell_map; the position of a cell
+    // in this array is its octant-local index into `cell_slots`.
+    LocalVector<CellKey> cells;
+    // multimesh instance for each cell in `cells`; only populated when custom
+    // data is enabled, and cleared whenever `cells` is modified.
+    LocalVector<HexMapMeshTool::InstanceSlot> cell_slots;
+
+    // only used to manage the multimeshes; the instances are built from the
+    // HexMapTiledNode cells in build_multimeshes().
+    HexMapMeshTool mesh_tool;
+
+    // index of the cell in `cells`, or the index it would be inserted at
+    uint32_t find_cell(CellKey) const;
+    bool has_cell(CellKey) const;
 
     // The baked mesh and the multimeshes are mutually exclusive
     Ref<ArrayMesh> baked_mesh;
     RID baked_mesh_instance;
 
     RID physics_body;
+    /// number of shapes added to physics_body
+    int physics_shape_count = 0;
     RID collision_debug_mesh;
     RID collision_debug_mesh_instance;
 
     bool dirty = false;
 
+    /// incremented every time the octant cells are modified
+    uint32_t revision = 0;
+
+    // merged mesh drawn in place of the multimeshes beyond the far LOD
+    // distance; built in the background by HexMapTiledNode.
+    Ref<ArrayMesh> far_mesh;
+    RID far_mesh_instance;
+    uint32_t far_mesh_revision = UINT32_MAX;
+    void create_far_mesh_instance();
+    void free_far_mesh_instance();
+
+    // navigation source geometry for the cells in the octant, in
+    // HexMapTiledNode local space; rebuilt when navigation_dirty is set.
+    PackedVector3Array navigation_vertices;
+    PackedInt32Array navigation_indices;
+    bool navigation_dirty = true;
+
     // clear and rebuild the multimeshes
+    void build_multimeshes();
     void build_physics_body();
     void build_baked_mesh();
 
@@ -50,6 +92,55 @@ private:
     void bake_mesh();
 
 public:
+    /// triangle surface from a MeshLibrary item mesh, decoded for baking
+    struct BakeSurface {
+        Ref<Material> material;
+        PackedVector3Array vertices;
+        PackedVector3Array normals;
+        PackedFloat32Array tangents;
+        PackedColorArray colors;
+        PackedVector2Array uvs;
+        PackedVector2Array uv2s;
+        PackedInt32Array indices;
+    };
+
+    /// decoded surfaces for each MeshLibrary item; shared between all octants
+    /// being baked so each item mesh is only fetched once.
+    using BakeSurfaceCache = HashMap<int, Vector<BakeSurface>>;
+
+    /// Everything needed to build the baked mesh for an octant.
+    ///
+    /// `prepare_bake()` and `commit_bake()` must be called on the main
+    /// thread, but `run()` only touches the job, so it can be run on a
+    /// WorkerThreadPool thread.
+    struct BakeJob {
+        /// single cell surface to be merged into the baked mesh
+        struct Instance {
+            /// points into the BakeSurfaceCache used to prepare the job
+            const BakeSurface *surface;
+            Transform3D transform;
+        };
+
+        /// all of the cell surfaces that share a material
+        struct Group {
+            Ref<Material> material;
+            Vector<Instance> instances;
+        };
+
+        Vector<Group> groups;
+        Transform3D global_transform;
+        bool gen_lightmap_uv = false;
+        float lightmap_uv_texel_size = 0.1;
+        /// generate decimated LODs for the mesh; used for far LOD meshes
+        bool generate_lods = false;
+
+        /// output of run()
+        Ref<ArrayMesh> mesh;
+
+        /// merge the cell geometry into `mesh`, and generate lightmap uvs
+        void run();
+    };
+
     /// Key type to use in HashMaps when referencing Octants
     union Key {
         struct {
@@ -76,6 +167,22 @@ public:
         _FORCE_INLINE_ operator uint64_t() const { return key; }
     };
 
+    /// Performance monitor counters, summed across every octant
+    static SafeNumeric<int64_t> monitor_octants;
+    static SafeNumeric<int64_t> monitor_physics_shapes;
+
+    /// bytes used by an octant, by category; see
+    /// HexMapTiledNode::get_memory_usage()
+    struct MemoryUsage {
+        size_t octant_cells = 0;
+        size_t multimesh_buffers = 0;
+        size_t multimesh_buffer_copies = 0;
+        size_t navigation_geometry = 0;
+    };
+
+    /// add the memory used by this octant to `usage`
+    void add_memory_usage(MemoryUsage &usage) const;
+
     HexMapOctant(HexMapTiledNode &hex_map);
     ~HexMapOctant();
 
@@ -86,20 +193,75 @@ public:
     void update_physics_params();
     void update_visibility();
 
+    /// update the global transform of every instance & body in the octant
+    /// without rebuilding them
+    void update_transform();
+
     void apply_changes();
 
-    void set_cell(CellKey, int, HexMapTileOrientation);
+    /// add a cell to the octant; the cell value must already be set in the
+    /// HexMapTiledNode
+    void set_cell(CellKey);
     void clear_cell(CellKey);
-    void set_cell_visibility(HexMapCellId, bool visible);
+
+    /// add a cell without keeping `cells` sorted, to fill a new octant in
+    /// bulk; `sort_cells()` must be called once all cells have been added
+    inline void append_cell(CellKey cell_key) { cells.push_back(cell_key); }
+    void sort_cells();
+
+    /// rebuild the octant after the `visible` or `occluded` flag of a cell in
+    /// the HexMapTiledNode has changed
+    void update_cell_visibility(CellKey);
     void set_all_cells_visible();
 
+    /// update the per-instance custom data without rebuilding the meshes
+    void set_cell_custom_data(CellKey, const Color &);
+    void set_cells_custom_data(const Vector<Pair<CellKey, Color>> &cells);
+
     inline bool is_empty() const { return cells.is_empty(); };
     inline bool is_dirty() const { return dirty; };
-    inline void set_dirty() { dirty = true; };
+    inline void set_dirty() {
+        dirty = true;
+        revision++;
+    };
+    inline uint32_t get_revision() const { return revision; };
+
+    /// check if the far LOD mesh is missing or out of date
+    inline bool needs_far_mesh() const {
+        return !cells.is_empty() && far_mesh_revision != revision;
+    };
+
+    /// set the far LOD mesh built from the cells at `mesh_revision`
+    void set_far_mesh(const Ref<ArrayMesh> &mesh, uint32_t mesh_revision);
+    void clear_far_mesh();
+
+    /// flag the navigation source geometry to be rebuilt
+    inline void set_navigation_dirty() { navigation_dirty = true; };
+
+    /// rebuild the navigation source geometry if it has been invalidated;
+    /// `surface_cache` is shared between octants so each item is only
+    /// decoded once.
+    void update_navigation_geometry(BakeSurfaceCache &surface_cache);
+    inline const PackedVector3Array &get_navigation_vertices() const {
+        return navigation_vertices;
+    }
+    inline const PackedInt32Array &get_navigation_indices() const {
+        return navigation_indices;
+    }
+
+    /// apply the HexMapTiledNode LOD visibility ranges to all instances
+    void update_visibility_range();
+
+    /// collect the cell geometry for baking; main thread only
+    void prepare_bake(BakeJob &, BakeSurfaceCache &) const;
+
+    /// replace the multimeshes with the mesh baked by `BakeJob::run()`
+    void commit_bake(const BakeJob &);
 
     // bake if needed and return the baked mesh
     void set_baked_mesh(Ref<Mesh> mesh);
     Ref<Mesh> get_baked_mesh();
+    inline bool has_baked_mesh() const { return baked_mesh.is_valid(); };
     void clear_baked_mesh();
     RID get_baked_mesh_instance() const;
 };
@@ -16,6 +16,8 @@
 #include <godot_cpp/classes/shape3d.hpp>
 #include <godot_cpp/classes/standard_material3d.hpp>
 #include <godot_cpp/classes/surface_tool.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/classes/worker_thread_pool.hpp>
 #include <godot_cpp/classes/world3d.hpp>
 #include <godot_cpp/core/error_macros.hpp>
 #include <godot_cpp/templates/pair.hpp>
@@ -35,6 +37,7 @@
 #include "core/hex_map_node.h"
 #include "core/iter_cube.h"
 #include "core/math.h"
+#include "core/memory_usage.h"
 #include "core/tile_orientation.h"
 #include "godot_cpp/classes/global_constants.hpp"
 #include "godot_cpp/core/class_db.hpp"
@@ -45,6 +48,9 @@
 #include "tiled_node.h"
 
 uint64_t HexMapTiledNode::navigation_source_geometry_parser = 0;
+SafeNumeric<int64_t> HexMapTiledNode::monitor_cells;
+SafeNumeric<int64_t> HexMapTiledNode::monitor_dirty_octants;
+SafeNumeric<uint64_t> HexMapTiledNode::monitor_update_usec;
 
 bool HexMapTiledNode::_set(const StringName &p_name, const Variant &p_value) {
     String name = p_name;
@@ -56,6 +62,10 @@ bool HexMapTiledNode::_set(const StringName &p_name, const Variant &p_value) {
             const PackedByteArray cells = d["cells"];
             ERR_FAIL_COND_V(cells.size() % 10 != 0, false);
 
+            // cells loaded here bypass set_cell(), so count them for the
+            // monitor; clear_internal() subtracts them again
+            uint32_t cell_count = cell_map.size();
+
             size_t offset = 0;
             while (offset < cells.size()) {
                 CellId::Key key;
@@ -72,6 +82,8 @@ bool HexMapTiledNode::_set(const StringName &p_name, const Variant &p_value) {
 
                 cell_map[key] = cell;
             }
+            monitor_cells.add(cell_map.size() - cell_count);
+            cells_modified();
         }
 
         recreate_octant_data();
@@ -104,17 +116,32 @@ bool HexMapTiledNode::_get(const StringName &p_name, Variant &r_ret) const {
     if (name == "data") {
         Dictionary d;
 
+        // save the cells in morton order so the saved data is stable, and
+        // neighboring cells are loaded into the same octant together
+        LocalVector<Pair<uint64_t, uint32_t>> sorted;
+        sorted.reserve(cell_map.size());
+        for (const auto &E : cell_map) {
+            // occluded depends on the neighboring cells and is recomputed on
+            // load; leave it out so the saved data only changes with the
+            // cell itself
+            Cell cell = E.value;
+            cell.occluded = 0;
+            sorted.push_back({ E.key.to_morton(), cell.cell });
+        }
+        sorted.sort_custom<PairSort<uint64_t, uint32_t>>();
+
         PackedByteArray cells;
         cells.resize(cell_map.size() * 10);
         size_t offset = 0;
-        for (const KeyValue<CellKey, Cell> &E : cell_map) {
-            cells.encode_s16(offset, E.key.q);
+        for (const auto &pair : sorted) {
+            CellKey key = CellKey::from_morton(pair.first);
+            cells.encode_s16(offset, key.q);
             offset += 2;
-            cells.encode_s16(offset, E.key.r);
+            cells.encode_s16(offset, key.r);
             offset += 2;
-            cells.encode_s16(offset, E.key.y);
+            cells.encode_s16(offset, key.y);
             offset += 2;
-            cells.encode_u32(offset, E.value.cell);
+            cells.encode_u32(offset, pair.second);
             offset += 4;
         }
 
@@ -286,6 +313,9 @@ void HexMapTiledNode::set_mesh_library(
                 callable_mp(this, &HexMapTiledNode::on_mesh_library_changed));
     }
     mesh_library = p_mesh_library;
+    // create the cache before we connect to `changed` so the cache is
+    // invalidated before on_mesh_library_changed() is called.
+    library_cache = HexMapLibraryCache::get(mesh_library);
     if (!mesh_library.is_null()) {
         mesh_library->connect("changed",
                 callable_mp(this, &HexMapTiledNode::on_mesh_library_changed));
@@ -302,6 +332,7 @@ bool HexMapTiledNode::on_mesh_library_changed() {
     for (const auto &iter : octants) {
         iter.value->set_dirty();
     }
+    mark_all_navigation_changed();
     update_dirty_octants();
     return true;
 }
@@ -317,6 +348,7 @@ void HexMapTiledNode::set_mesh_origin(HexMapTiledNode::MeshOrigin value) {
     for (const auto pair : octants) {
         pair.value->set_dirty();
     }
+    mark_all_navigation_changed();
     update_dirty_octants();
     emit_signal("mesh_origin_changed");
 }
@@ -336,16 +368,128 @@ Vector3 HexMapTiledNode::get_mesh_origin_vec() const {
     }
 }
 
+void HexMapTiledNode::set_custom_data_format(CustomDataFormat value) {
+    if (custom_data_format == value) {
+        return;
+    }
+    custom_data_format = value;
+    for (const auto &iter : octants) {
+        iter.value->set_dirty();
+    }
+    update_dirty_octants();
+}
+
+HexMapTiledNode::CustomDataFormat HexMapTiledNode::get_custom_data_format()
+        const {
+    return custom_data_format;
+}
+
+void HexMapTiledNode::set_cell_custom_data(const HexMapCellId &cell_id,
+        const Color &value) {
+    ERR_FAIL_COND_MSG(
+            !cell_id.in_bounds(), "cell id is not in bounds: " + cell_id);
+    if (!cell_map.has(cell_id)) {
+        return;
+    }
+    if (value == Color(1, 1, 1, 1)) {
+        cell_custom_data.erase(cell_id);
+    } else {
+        cell_custom_data.insert(cell_id, value);
+    }
+
+    Octant **octant = octants.getptr(OctantKey(cell_id, octant_size));
+    ERR_FAIL_COND_MSG(
+            octant == nullptr, "no octant found for valid cell: " + cell_id);
+    (*octant)->set_cell_custom_data(cell_id, value);
+}
+
+void HexMapTiledNode::_set_cell_custom_data(
+        const Ref<hex_bind::HexMapCellId> ref,
+        const Color &value) {
+    ERR_FAIL_COND_MSG(!ref.is_valid(), "first argument was not HexMapCellId");
+    set_cell_custom_data(ref->inner, value);
+}
+
+Color HexMapTiledNode::get_cell_custom_data(
+        const HexMapCellId &cell_id) const {
+    ERR_FAIL_COND_V_MSG(!cell_id.in_bounds(),
+            Color(1, 1, 1, 1),
+            "cell id is not in bounds: " + cell_id);
+    const Color *value = cell_custom_data.getptr(cell_id);
+    return value != nullptr ? *value : Color(1, 1, 1, 1);
+}
+
+Color HexMapTiledNode::_get_cell_custom_data(
+        const Ref<hex_bind::HexMapCellId> ref) const {
+    ERR_FAIL_COND_V_MSG(!ref.is_valid(),
+            Color(1, 1, 1, 1),
+            "argument was not HexMapCellId");
+    return get_cell_custom_data(ref->inner);
+}
+
+void HexMapTiledNode::set_cells_custom_data(const Array cells) {
+    auto prof = profiling_begin("HexMapTiledNode::set_cells_custom_data()");
+    int size = cells.size();
+    ERR_FAIL_COND_MSG(size % 2 != 0,
+            "set_cells_custom_data(): Array size must be a multiple of 2");
+
+    // group the updates by octant so each multimesh buffer is only uploaded
+    // once
+    HashMap<OctantKey, Vector<Pair<CellKey, Color>>> octant_cells;
+    for (int i = 0; i < size; i += 2) {
+        HexMapCellId cell_id((Vector3i)cells[i]);
+        ERR_CONTINUE_MSG(!cell_id.in_bounds(),
+                "cell id is not in bounds: " + cell_id);
+        if (!cell_map.has(cell_id)) {
+            continue;
+        }
+        Color value = cells[i + 1];
+        if (value == Color(1, 1, 1, 1)) {
+            cell_custom_data.erase(cell_id);
+        } else {
+            cell_custom_data.insert(cell_id, value);
+        }
+
+        OctantKey octant_key(cell_id, octant_size);
+        auto *list = octant_cells.getptr(octant_key);
+        if (list == nullptr) {
+            list = &octant_cells.insert(octant_key, {})->value;
+        }
+        list->push_back({ CellKey(cell_id), value });
+    }
+
+    for (const auto &iter : octant_cells) {
+        Octant **octant = octants.getptr(iter.key);
+        if (octant != nullptr) {
+            (*octant)->set_cells_custom_data(iter.value);
+        }
+    }
+}
+
+Ref<ArrayMesh> HexMapTiledNode::get_placeholder_mesh() {
+    if (!placeholder_mesh.is_valid()) {
+        placeholder_mesh = space.build_placeholder_mesh();
+    }
+    return placeholder_mesh;
+}
+
 bool HexMapTiledNode::on_hex_space_changed() {
     HexMapNode::on_hex_space_changed();
+    placeholder_mesh = Ref<ArrayMesh>();
     clear_baked_meshes();
     for (const auto &iter : octants) {
         iter.value->set_dirty();
     }
+    mark_all_navigation_changed();
     update_dirty_octants();
     return true;
 }
 
+void HexMapTiledNode::on_hex_space_transform_changed() {
+    HexMapNode::on_hex_space_transform_changed();
+    update_octant_transforms();
+}
+
 void HexMapTiledNode::set_octant_size(int p_size) {
     ERR_FAIL_COND(p_size == 0);
     octant_size = p_size;
@@ -355,13 +499,262 @@ void HexMapTiledNode::set_octant_size(int p_size) {
 int HexMapTiledNode::get_octant_size() const { return octant_size; }
 
 void HexMapTiledNode::set_navigation_bake_only_navmesh_tiles(bool value) {
+    if (navigation_bake_only_navmesh_tiles == value) {
+        return;
+    }
     navigation_bake_only_navmesh_tiles = value;
+    mark_all_navigation_changed();
 }
 
 bool HexMapTiledNode::get_navigation_bake_only_navmesh_tiles() const {
     return navigation_bake_only_navmesh_tiles;
 }
 
+void HexMapTiledNode::set_navigation_use_item_navmesh(bool value) {
+    if (navigation_use_item_navmesh == value) {
+        return;
+    }
+    navigation_use_item_navmesh = value;
+    mark_all_navigation_changed();
+}
+
+bool HexMapTiledNode::get_navigation_use_item_navmesh() const {
+    return navigation_use_item_navmesh;
+}
+
+void HexMapTiledNode::set_lod_visibility_range_begin(real_t value) {
+    lod_visibility_range_begin = value;
+    update_octant_visibility_ranges();
+}
+
+real_t HexMapTiledNode::get_lod_visibility_range_begin() const {
+    return lod_visibility_range_begin;
+}
+
+void HexMapTiledNode::set_lod_visibility_range_end(real_t value) {
+    lod_visibility_range_end = value;
+    update_octant_visibility_ranges();
+}
+
+real_t HexMapTiledNode::get_lod_visibility_range_end() const {
+    return lod_visibility_range_end;
+}
+
+void HexMapTiledNode::set_lod_far_mesh_enabled(bool value) {
+    if (lod_far_mesh_enabled == value) {
+        return;
+    }
+    lod_far_mesh_enabled = value;
+
+    if (lod_far_mesh_enabled) {
+        queue_far_meshes();
+    } else {
+        cancel_far_meshes();
+        for (const auto &iter : octants) {
+            iter.value->clear_far_mesh();
+        }
+    }
+}
+
+bool HexMapTiledNode::get_lod_far_mesh_enabled() const {
+    return lod_far_mesh_enabled;
+}
+
+void HexMapTiledNode::set_lod_far_mesh_distance(real_t value) {
+    lod_far_mesh_distance = value;
+    update_octant_visibility_ranges();
+}
+
+real_t HexMapTiledNode::get_lod_far_mesh_distance() const {
+    return lod_far_mesh_distance;
+}
+
+void HexMapTiledNode::update_octant_visibility_ranges() {
+    for (const auto &iter : octants) {
+        iter.value->update_visibility_range();
+    }
+}
+
+void HexMapTiledNode::far_mesh_task(uint32_t p_index) {
+    far_mesh_tasks[p_index].job.run();
+}
+
+void HexMapTiledNode::queue_far_meshes() {
+    if (!lod_far_mesh_enabled || far_mesh_group_id != -1 ||
+            !library_cache.is_valid() || !is_inside_tree()) {
+        return;
+    }
+
+    auto prof = profiling_begin("HexMapTiledNode::queue_far_meshes()");
+
+    // collect the cell geometry for every octant with a missing or stale far
+    // mesh on the main thread; the merge & decimation happen on the workers.
+    for (const auto &iter : octants) {
+        Octant *octant = iter.value;
+        if (!octant->needs_far_mesh()) {
+            continue;
+        }
+        far_mesh_tasks.push_back(FarMeshTask{
+                .octant = iter.key,
+                .revision = octant->get_revision(),
+        });
+        HexMapOctant::BakeJob &job =
+                far_mesh_tasks[far_mesh_tasks.size() - 1].job;
+        job.generate_lods = true;
+        octant->prepare_bake(job, far_mesh_surface_cache);
+    }
+
+    if (far_mesh_tasks.is_empty()) {
+        far_mesh_surface_cache.clear();
+        return;
+    }
+
+    far_mesh_group_id = WorkerThreadPool::get_singleton()->add_group_task(
+            callable_mp(this, &HexMapTiledNode::far_mesh_task),
+            far_mesh_tasks.size(),
+            -1,
+            true,
+            "HexMapTiledNode: build far LOD meshes");
+
+    // poll for completion in NOTIFICATION_INTERNAL_PROCESS
+    set_process_internal(true);
+}
+
+void HexMapTiledNode::commit_far_meshes() {
+    ERR_FAIL_COND(far_mesh_group_id == -1);
+    WorkerThreadPool::get_singleton()->wait_for_group_task_completion(
+            far_mesh_group_id);
+    far_mesh_group_id = -1;
+    set_process_internal(false);
+
+    // Only use the meshes for octants that haven't been modified while the
+    // mesh was being built.  Modified octants keep their previous far mesh
+    // until the rebuild queued below finishes.
+    for (const FarMeshTask &task : far_mesh_tasks) {
+        Octant **octant = octants.getptr(task.octant);
+        if (octant == nullptr || (*octant)->get_revision() != task.revision) {
+            continue;
+        }
+        (*octant)->set_far_mesh(task.job.mesh, task.revision);
+    }
+    far_mesh_tasks.clear();
+    far_mesh_surface_cache.clear();
+
+    queue_far_meshes();
+}
+
+void HexMapTiledNode::cancel_far_meshes() {
+    if (far_mesh_group_id == -1) {
+        return;
+    }
+    // there's no way to abort a group task; wait for it and throw the
+    // results away.
+    WorkerThreadPool::get_singleton()->wait_for_group_task_completion(
+            far_mesh_group_id);
+    far_mesh_group_id = -1;
+    far_mesh_tasks.clear();
+    far_mesh_surface_cache.clear();
+    set_process_internal(false);
+}
+
+void HexMapTiledNode::set_occlusion_culling_enabled(bool value) {
+    if (occlusion_culling_enabled == value) {
+        return;
+    }
+    occlusion_culling_enabled = value;
+    update_all_occlusion();
+}
+
+bool HexMapTiledNode::get_occlusion_culling_enabled() const {
+    return occlusion_culling_enabled;
+}
+
+void HexMapTiledNode::set_occlusion_culling_occluders(
+        const PackedInt32Array &value) {
+    occlusion_culling_occluders.clear();
+    for (int32_t id : value) {
+        occlusion_culling_occluders.insert(id);
+    }
+    update_all_occlusion();
+}
+
+PackedInt32Array HexMapTiledNode::get_occlusion_culling_occluders() const {
+    PackedInt32Array out;
+    for (int id : occlusion_culling_occluders) {
+        out.push_back(id);
+    }
+    return out;
+}
+
+// the cells that must all be occluders to hide a cell; the six neighbors in
+// the same layer, and the cells directly above & below.
+static const HexMapCellId enclosing_cell_offsets[] = {
+    HexMapCellId(1, 0, 0),
+    HexMapCellId(1, -1, 0),
+    HexMapCellId(0, -1, 0),
+    HexMapCellId(-1, 0, 0),
+    HexMapCellId(-1, 1, 0),
+    HexMapCellId(0, 1, 0),
+    HexMapCellId(0, 0, 1),
+    HexMapCellId(0, 0, -1),
+};
+
+bool HexMapTiledNode::is_occluder(const CellKey &key) const {
+    const Cell *cell = cell_map.getptr(key);
+    // cells hidden by the editor don't occlude anything
+    return cell != nullptr && cell->visible &&
+            occlusion_culling_occluders.has(cell->value);
+}
+
+bool HexMapTiledNode::is_cell_enclosed(const HexMapCellId &cell_id) const {
+    for (const HexMapCellId &offset : enclosing_cell_offsets) {
+        HexMapCellId neighbor = cell_id + offset;
+        if (!neighbor.in_bounds() || !is_occluder(neighbor)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void HexMapTiledNode::update_cell_occlusion(const HexMapCellId &cell_id) {
+    if (!cell_id.in_bounds()) {
+        return;
+    }
+    Cell *cell = cell_map.getptr(cell_id);
+    if (cell == nullptr) {
+        return;
+    }
+    bool occluded = occlusion_culling_enabled && is_cell_enclosed(cell_id);
+    if (cell->occluded == occluded) {
+        return;
+    }
+    cell->occluded = occluded;
+
+    // the baked mesh skipped occluded cells, so it must be rebuilt too
+    Octant **octant = octants.getptr(OctantKey(cell_id, octant_size));
+    ERR_FAIL_COND_MSG(
+            octant == nullptr, "no octant found for valid cell: " + cell_id);
+    (**octant).update_cell_visibility(cell_id);
+}
+
+void HexMapTiledNode::update_occlusion_around(const HexMapCellId &cell_id) {
+    if (!occlusion_culling_enabled) {
+        return;
+    }
+    update_cell_occlusion(cell_id);
+    for (const HexMapCellId &offset : enclosing_cell_offsets) {
+        update_cell_occlusion(cell_id + offset);
+    }
+}
+
+void HexMapTiledNode::update_all_occlusion() {
+    auto prof = profiling_begin("HexMapTiledNode::update_all_occlusion()");
+    for (const auto &iter : cell_map) {
+        update_cell_occlusion(iter.key);
+    }
+    update_dirty_octants();
+}
+
 void HexMapTiledNode::set_cell(const HexMapCellId &cell_id,
         int value,
         HexMapTileOrientation orientation) {
@@ -392,14 +785,24 @@ void HexMapTiledNode::set_cell(const HexMapCellId &cell_id,
     Octant **octant_ptr = octants.getptr(octant_key);
     Octant *octant = octant_ptr ? *octant_ptr : nullptr;
 
+    // mark the region covered by the current item before it is replaced
+    if (current_cell != nullptr) {
+        mark_navigation_changed(cell_id);
+    }
+
     if (value >= 0) {
         // set the cell
         Cell cell = {
             .value = static_cast<unsigned int>(value),
             .rot = static_cast<unsigned int>(orientation),
             .visible = true,
+            .occluded = current_cell != nullptr ? current_cell->occluded : 0u,
         };
         cell_map.insert(cell_key, cell);
+        cells_modified();
+        if (current_cell == nullptr) {
+            monitor_cells.increment();
+        }
 
         // create a new octant if one doesn't already exist for this cell
         if (octant == nullptr) {
@@ -412,15 +815,21 @@ void HexMapTiledNode::set_cell(const HexMapCellId &cell_id,
         }
 
         // add a cell to the octant, and schedule an update
-        octant->set_cell(cell_key, value, orientation);
+        octant->set_cell(cell_key);
+        mark_navigation_changed(cell_id);
+        update_occlusion_around(cell_id);
         update_dirty_octants();
 
     } else if (current_cell != nullptr) {
         // clear the cell
         cell_map.erase(cell_key);
+        cell_custom_data.erase(cell_key);
+        cells_modified();
+        monitor_cells.decrement();
 
         ERR_FAIL_COND_MSG(octant == nullptr, "octant for cell does not exist");
         octant->clear_cell(cell_key);
+        update_occlusion_around(cell_id);
         update_dirty_octants();
     }
 
@@ -445,6 +854,32 @@ Array HexMapTiledNode::find_cell_vecs_by_value(int value) const {
     return out;
 }
 
+Dictionary HexMapTiledNode::get_memory_usage() const {
+    Octant::MemoryUsage octant_usage;
+    for (const auto &iter : octants) {
+        iter.value->add_memory_usage(octant_usage);
+    }
+
+    // multimesh buffers are owned by the RenderingServer, so they're reported
+    // separately and not included in the total.
+    Dictionary out;
+    int64_t total = 0;
+    auto add = [&](const char *name, size_t bytes) {
+        out[name] = (int64_t)bytes;
+        total += bytes;
+    };
+    add("cell_map", ::get_memory_usage(cell_map));
+    add("octants",
+            ::get_memory_usage(octants) + octants.size() * sizeof(Octant));
+    add("cell_custom_data", ::get_memory_usage(cell_custom_data));
+    add("octant_cells", octant_usage.octant_cells);
+    add("multimesh_buffer_copies", octant_usage.multimesh_buffer_copies);
+    add("navigation_geometry", octant_usage.navigation_geometry);
+    out["total"] = total;
+    out["multimesh_buffers"] = (int64_t)octant_usage.multimesh_buffers;
+    return out;
+}
+
 HexMapNode::CellInfo HexMapTiledNode::get_cell(
         const HexMapCellId &cell_id) const {
     const Cell *current_cell = cell_map.getptr(cell_id);
@@ -455,6 +890,15 @@ HexMapNode::CellInfo HexMapTiledNode::get_cell(
         .orientation = HexMapTileOrientation(current_cell->rot) };
 }
 
+void HexMapTiledNode::snapshot_cells(HexMapCellMap<CellInfo> &cells) const {
+    cells.reserve(cell_map.size());
+    for (const auto &iter : cell_map) {
+        cells.insert(iter.key,
+                CellInfo{ .value = static_cast<int>(iter.value.value),
+                        .orientation = HexMapTileOrientation(iter.value.rot) });
+    }
+}
+
 bool HexMapTiledNode::has(HexMapCellId cell_id) const {
     return cell_map.has(cell_id);
 }
@@ -477,7 +921,8 @@ void HexMapTiledNode::set_cell_visibility(const HexMapCellId &cell_id,
     Octant **octant = octants.getptr(octant_key);
     ERR_FAIL_COND_MSG(
             octant == nullptr, "no octant found for valid cell: " + cell_id);
-    (**octant).set_cell_visibility(cell_id, visibility);
+    (**octant).update_cell_visibility(cell_key);
+    update_occlusion_around(cell_id);
     update_dirty_octants();
 
     // Although we aren't truely modifying the map here, covering the edge case
@@ -494,35 +939,35 @@ void HexMapTiledNode::set_cell_visibility(const HexMapCellId &cell_id,
 }
 
 void HexMapTiledNode::_notification(int p_what) {
-    static Transform3D last_transform;
-
+    // NOTIFICATION_TRANSFORM_CHANGED is handled by HexMapNode, which calls
+    // on_hex_space_transform_changed() when the global transform changes.
     switch (p_what) {
     case NOTIFICATION_ENTER_WORLD:
         for (auto &pair : octants) {
             pair.value->enter_world();
         }
-        last_transform = get_global_transform();
+        queue_far_meshes();
         break;
 
     case NOTIFICATION_ENTER_TREE:
         _update_visibility();
         break;
 
-    case NOTIFICATION_TRANSFORM_CHANGED: {
-        Transform3D transform = get_global_transform();
-        if (transform != last_transform) {
-            space.set_transform(transform);
-            update_octant_meshes();
-            last_transform = transform;
-        }
-        break;
-    }
     case NOTIFICATION_EXIT_WORLD:
+        cancel_far_meshes();
         for (auto &pair : octants) {
             pair.value->exit_world();
         }
         break;
 
+    case NOTIFICATION_INTERNAL_PROCESS:
+        if (far_mesh_group_id != -1 &&
+                WorkerThreadPool::get_singleton()->is_group_task_completed(
+                        far_mesh_group_id)) {
+            commit_far_meshes();
+        }
+        break;
+
     case NOTIFICATION_VISIBILITY_CHANGED:
         _update_visibility();
         break;
@@ -542,6 +987,8 @@ void HexMapTiledNode::_update_visibility() {
 void HexMapTiledNode::update_dirty_octants_callback() {
     ERR_FAIL_COND_MSG(!awaiting_update,
             "update_dirty_octants_callback() called unexpectedly");
+    uint64_t start_usec = Time::get_singleton()->get_ticks_usec();
+    int64_t dirty_count = 0;
     Vector<OctantKey> empty_octants;
     for (const auto pair : octants) {
         Octant *octant = pair.value;
@@ -550,6 +997,7 @@ void HexMapTiledNode::update_dirty_octants_callback() {
         }
 
         octant->apply_changes();
+        dirty_count++;
         if (octant->is_empty()) {
             empty_octants.push_back(pair.key);
         } else {
@@ -564,6 +1012,11 @@ void HexMapTiledNode::update_dirty_octants_callback() {
     }
 
     awaiting_update = false;
+    queue_far_meshes();
+
+    monitor_dirty_octants.set(dirty_count);
+    monitor_update_usec.set(
+            Time::get_singleton()->get_ticks_usec() - start_usec);
 }
 
 void HexMapTiledNode::update_dirty_octants() {
@@ -581,12 +1034,65 @@ void HexMapTiledNode::update_octant_meshes() {
     }
 }
 
+void HexMapTiledNode::update_octant_transforms() {
+    if (!is_inside_tree()) {
+        return;
+    }
+    for (auto &it : octants) {
+        it.value->update_transform();
+    }
+}
+
 void HexMapTiledNode::recreate_octant_data() {
-    HashMap<CellKey, Cell> cell_copy = cell_map;
+    auto prof = profiling_begin("HexMapTiledNode::recreate_octant_data()");
+    HexMapCellMap<Cell> cell_copy = cell_map;
+    HexMapCellMap<Color> custom_data_copy = cell_custom_data;
+
     clear_internal();
-    for (const KeyValue<CellKey, Cell> &E : cell_copy) {
-        set_cell(CellId(E.key), E.value.value, E.value.rot);
+    baked_mesh_octants.clear();
+
+    // Fill the octants in bulk and sort each one once.  Going through
+    // set_cell() would insert every cell into a sorted array, which is
+    // quadratic in the octant size, and update the occlusion around every
+    // cell.
+    cell_map.reserve(cell_copy.size());
+    for (const auto &E : cell_copy) {
+        cell_map.insert(E.key,
+                Cell{
+                        .value = E.value.value,
+                        .rot = E.value.rot,
+                        .visible = true,
+                });
+
+        OctantKey octant_key(CellId(E.key), octant_size);
+        Octant **octant_ptr = octants.getptr(octant_key);
+        Octant *octant = octant_ptr ? *octant_ptr : nullptr;
+        if (octant == nullptr) {
+            octant = new Octant(*this);
+            octants.insert(octant_key, octant);
+
+            if (is_inside_tree()) {
+                octant->enter_world();
+            }
+        }
+        octant->append_cell(E.key);
+    }
+    for (auto &iter : octants) {
+        iter.value->sort_cells();
+    }
+    monitor_cells.add(cell_map.size());
+    cells_modified();
+
+    mark_all_navigation_changed();
+    if (occlusion_culling_enabled) {
+        update_all_occlusion();
+    } else {
+        update_dirty_octants();
     }
+
+    // the new octants are dirty, and will pick up the custom data when they
+    // are built
+    cell_custom_data = custom_data_copy;
 }
 
 void HexMapTiledNode::clear_internal() {
@@ -598,7 +1104,10 @@ void HexMapTiledNode::clear_internal() {
         delete octant;
     }
     octants.clear();
+    monitor_cells.sub(cell_map.size());
     cell_map.clear();
+    cell_custom_data.clear();
+    cells_modified();
 }
 
 void HexMapTiledNode::clear() {
@@ -659,6 +1168,52 @@ void HexMapTiledNode::_bind_methods() {
             &HexMapTiledNode::set_navigation_bake_only_navmesh_tiles);
     ClassDB::bind_method(D_METHOD("get_navigation_bake_only_navmesh_tiles"),
             &HexMapTiledNode::get_navigation_bake_only_navmesh_tiles);
+    ClassDB::bind_method(
+            D_METHOD("set_navigation_use_item_navmesh", "enable"),
+            &HexMapTiledNode::set_navigation_use_item_navmesh);
+    ClassDB::bind_method(D_METHOD("get_navigation_use_item_navmesh"),
+            &HexMapTiledNode::get_navigation_use_item_navmesh);
+    ClassDB::bind_method(D_METHOD("set_lod_visibility_range_begin", "value"),
+            &HexMapTiledNode::set_lod_visibility_range_begin);
+    ClassDB::bind_method(D_METHOD("get_lod_visibility_range_begin"),
+            &HexMapTiledNode::get_lod_visibility_range_begin);
+    ClassDB::bind_method(D_METHOD("set_lod_visibility_range_end", "value"),
+            &HexMapTiledNode::set_lod_visibility_range_end);
+    ClassDB::bind_method(D_METHOD("get_lod_visibility_range_end"),
+            &HexMapTiledNode::get_lod_visibility_range_end);
+    ClassDB::bind_method(D_METHOD("set_lod_far_mesh_enabled", "enabled"),
+            &HexMapTiledNode::set_lod_far_mesh_enabled);
+    ClassDB::bind_method(D_METHOD("get_lod_far_mesh_enabled"),
+            &HexMapTiledNode::get_lod_far_mesh_enabled);
+    ClassDB::bind_method(D_METHOD("set_lod_far_mesh_distance", "value"),
+            &HexMapTiledNode::set_lod_far_mesh_distance);
+    ClassDB::bind_method(D_METHOD("get_lod_far_mesh_distance"),
+            &HexMapTiledNode::get_lod_far_mesh_distance);
+    ClassDB::bind_method(D_METHOD("set_custom_data_format", "format"),
+            &HexMapTiledNode::set_custom_data_format);
+    ClassDB::bind_method(D_METHOD("get_custom_data_format"),
+            &HexMapTiledNode::get_custom_data_format);
+    ClassDB::bind_method(D_METHOD("set_cell_custom_data", "cell_id", "value"),
+            &HexMapTiledNode::_set_cell_custom_data);
+    ClassDB::bind_method(D_METHOD("get_cell_custom_data", "cell_id"),
+            &HexMapTiledNode::_get_cell_custom_data);
+    ClassDB::bind_method(D_METHOD("set_cells_custom_data", "cells"),
+            &HexMapTiledNode::set_cells_custom_data);
+
+    ClassDB::bind_method(D_METHOD("get_navigation_changed_aabb"),
+            &HexMapTiledNode::get_navigation_changed_aabb);
+    ClassDB::bind_method(D_METHOD("clear_navigation_changed_aabb"),
+            &HexMapTiledNode::clear_navigation_changed_aabb);
+    ClassDB::bind_method(
+            D_METHOD("set_occlusion_culling_enabled", "enabled"),
+            &HexMapTiledNode::set_occlusion_culling_enabled);
+    ClassDB::bind_method(D_METHOD("get_occlusion_culling_enabled"),
+            &HexMapTiledNode::get_occlusion_culling_enabled);
+    ClassDB::bind_method(
+            D_METHOD("set_occlusion_culling_occluders", "item_ids"),
+            &HexMapTiledNode::set_occlusion_culling_occluders);
+    ClassDB::bind_method(D_METHOD("get_occlusion_culling_occluders"),
+            &HexMapTiledNode::get_occlusion_culling_occluders);
 
     ClassDB::bind_method(D_METHOD("set_octant_size", "size"),
             &HexMapTiledNode::set_octant_size);
@@ -710,6 +1265,12 @@ void HexMapTiledNode::_bind_methods() {
                          "Center,Top,Bottom"),
             "set_mesh_origin",
             "get_mesh_origin");
+    ADD_PROPERTY(PropertyInfo(Variant::INT,
+                         "cell_custom_data_format",
+                         PROPERTY_HINT_ENUM,
+                         "None,Color,Custom"),
+            "set_custom_data_format",
+            "get_custom_data_format");
 
     ADD_GROUP("Collision", "collision_");
     ADD_PROPERTY(PropertyInfo(Variant::BOOL,
@@ -730,12 +1291,47 @@ void HexMapTiledNode::_bind_methods() {
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "collision_priority"),
             "set_collision_priority",
             "get_collision_priority");
+    ADD_GROUP("LOD", "lod_");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT,
+                         "lod_visibility_range_begin",
+                         PROPERTY_HINT_RANGE,
+                         "0,4096,0.01,or_greater,suffix:m"),
+            "set_lod_visibility_range_begin",
+            "get_lod_visibility_range_begin");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT,
+                         "lod_visibility_range_end",
+                         PROPERTY_HINT_RANGE,
+                         "0,4096,0.01,or_greater,suffix:m"),
+            "set_lod_visibility_range_end",
+            "get_lod_visibility_range_end");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "lod_far_mesh_enabled"),
+            "set_lod_far_mesh_enabled",
+            "get_lod_far_mesh_enabled");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT,
+                         "lod_far_mesh_distance",
+                         PROPERTY_HINT_RANGE,
+                         "0,4096,0.01,or_greater,suffix:m"),
+            "set_lod_far_mesh_distance",
+            "get_lod_far_mesh_distance");
+
+    ADD_GROUP("Occlusion Culling", "occlusion_culling_");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "occlusion_culling_enabled"),
+            "set_occlusion_culling_enabled",
+            "get_occlusion_culling_enabled");
+    ADD_PROPERTY(PropertyInfo(Variant::PACKED_INT32_ARRAY,
+                         "occlusion_culling_occluders"),
+            "set_occlusion_culling_occluders",
+            "get_occlusion_culling_occluders");
+
     ADD_GROUP("Navigation", "navigation_");
 
     ADD_PROPERTY(
             PropertyInfo(Variant::BOOL, "navigation_bake_only_navmesh_tiles"),
             "set_navigation_bake_only_navmesh_tiles",
             "get_navigation_bake_only_navmesh_tiles");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "navigation_use_item_navmesh"),
+            "set_navigation_use_item_navmesh",
+            "get_navigation_use_item_navmesh");
 
     BIND_CONSTANT(CELL_VALUE_NONE);
 
@@ -748,6 +1344,9 @@ void HexMapTiledNode::_bind_methods() {
     BIND_ENUM_CONSTANT(MESH_ORIGIN_CENTER);
     BIND_ENUM_CONSTANT(MESH_ORIGIN_BOTTOM);
     BIND_ENUM_CONSTANT(MESH_ORIGIN_TOP);
+    BIND_ENUM_CONSTANT(CUSTOM_DATA_NONE);
+    BIND_ENUM_CONSTANT(CUSTOM_DATA_COLOR);
+    BIND_ENUM_CONSTANT(CUSTOM_DATA_CUSTOM);
 }
 
 void HexMapTiledNode::clear_baked_meshes() {
@@ -757,10 +1356,70 @@ void HexMapTiledNode::clear_baked_meshes() {
     baked_mesh_octants.clear();
 }
 
+void HexMapTiledNode::bake_octant_task(uint32_t p_index) {
+    bake_jobs[p_index].run();
+}
+
+void HexMapTiledNode::bake_octants(const Vector<OctantKey> &keys,
+        bool p_gen_lightmap_uv,
+        float p_lightmap_uv_texel_size) {
+    auto profiler = profiling_begin("HexMapTiledNode::bake_octants()");
+
+    if (keys.is_empty() || !library_cache.is_valid()) {
+        return;
+    }
+
+    // Collect the cell geometry for each octant on the main thread; nothing
+    // in the scene tree or MeshLibrary is touched after this point until
+    // the jobs are committed.
+    HexMapOctant::BakeSurfaceCache surface_cache;
+    bake_jobs.resize(keys.size());
+    for (int i = 0; i < keys.size(); i++) {
+        HexMapOctant::BakeJob &job = bake_jobs[i];
+        job.gen_lightmap_uv = p_gen_lightmap_uv;
+        job.lightmap_uv_texel_size = p_lightmap_uv_texel_size;
+        octants[keys[i]]->prepare_bake(job, surface_cache);
+    }
+
+    // merge the meshes & unwrap the lightmap uvs for every octant in
+    // parallel; lightmap_unwrap() is by far the most expensive part.
+    WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+    int64_t group_id = pool->add_group_task(
+            callable_mp(this, &HexMapTiledNode::bake_octant_task),
+            bake_jobs.size(),
+            -1,
+            true,
+            "HexMapTiledNode: bake octant meshes");
+    pool->wait_for_group_task_completion(group_id);
+
+    for (int i = 0; i < keys.size(); i++) {
+        octants[keys[i]]->commit_bake(bake_jobs[i]);
+    }
+    bake_jobs.clear();
+}
+
 void HexMapTiledNode::make_baked_meshes(bool p_gen_lightmap_uv,
-        float p_lightmap_uv_texel_size) {}
+        float p_lightmap_uv_texel_size) {
+    clear_baked_meshes();
+
+    Vector<OctantKey> keys;
+    for (const auto &it : octants) {
+        keys.push_back(it.key);
+    }
+    bake_octants(keys, p_gen_lightmap_uv, p_lightmap_uv_texel_size);
+}
 
 Array HexMapTiledNode::get_bake_meshes() {
+    // bake any octants that don't already have a baked mesh in one pass so
+    // they can be built in parallel.
+    Vector<OctantKey> unbaked;
+    for (const auto &it : octants) {
+        if (!it.value->has_baked_mesh()) {
+            unbaked.push_back(it.key);
+        }
+    }
+    bake_octants(unbaked, true);
+
     baked_mesh_octants.clear();
     Array arr;
     for (auto &it : octants) {
@@ -817,7 +1476,10 @@ HexMapTiledNode::HexMapTiledNode() {
     }
 }
 
-HexMapTiledNode::~HexMapTiledNode() { clear(); }
+HexMapTiledNode::~HexMapTiledNode() {
+    cancel_far_meshes();
+    clear();
+}
 
 bool HexMapTiledNode::generate_navigation_source_geometry(Ref<NavigationMesh>,
         Ref<NavigationMeshSourceGeometryData3D> source_geometry_data,
@@ -826,44 +1488,25 @@ bool HexMapTiledNode::generate_navigation_source_geometry(Ref<NavigationMesh>,
     if (node == nullptr) {
         return false;
     }
-
-    // calculate the mesh origin offset for each cell; this allows us to put
-    // the origin at the bottom or top of the cell, instead of the center.
-    Vector3 mesh_origin_offset =
-            node->get_mesh_origin_vec() * node->space.get_cell_scale();
-
-    for (const auto &it : node->cell_map) {
-        const Cell &cell = it.value;
-
-        if (node->navigation_bake_only_navmesh_tiles) {
-            // If there's a tile in the cell above this one, do not include
-            // this tile, otherwise when a navigable mesh has a
-            // non-navigable on top, the nav mesh incorrectly cuts through
-            // that upper tile.
-            if (it.key.y < SHRT_MAX &&
-                    node->cell_map.has(it.key.get_cell_above())) {
-                continue;
-            }
-
-            // if the cell doesn't have a navmesh, skip it
-            if (!node->mesh_library->get_item_navigation_mesh(cell.value)
-                            .is_valid()) {
-                continue;
-            }
-        }
-
-        Ref<Mesh> mesh = node->mesh_library->get_item_mesh(cell.value);
-        if (!mesh.is_valid()) {
+    auto prof = profiling_begin(
+            "HexMapTiledNode::generate_navigation_source_geometry()");
+
+    // Each octant caches its geometry in local space, and only rebuilds it
+    // when cells in (or above) the octant have changed.
+    HexMapOctant::BakeSurfaceCache surface_cache;
+    Transform3D transform = node->space.get_transform();
+    Array arrays;
+    arrays.resize(Mesh::ARRAY_MAX);
+
+    for (const auto &it : node->octants) {
+        Octant *octant = it.value;
+        octant->update_navigation_geometry(surface_cache);
+        if (octant->get_navigation_vertices().is_empty()) {
             continue;
         }
-
-        Transform3D cell_transform(cell.get_basis(),
-                node->space.get_cell_center_global(it.key) +
-                        mesh_origin_offset);
-        source_geometry_data->add_mesh(mesh,
-                cell_transform *
-                        node->mesh_library->get_item_mesh_transform(
-                                cell.value));
+        arrays[Mesh::ARRAY_VERTEX] = octant->get_navigation_vertices();
+        arrays[Mesh::ARRAY_INDEX] = octant->get_navigation_indices();
+        source_geometry_data->add_mesh_array(arrays, transform);
     }
 
     // Unused return value.  To turn this function into a Callable, the
@@ -871,3 +1514,64 @@ bool HexMapTiledNode::generate_navigation_source_geometry(Ref<NavigationMesh>,
     // is not a supported option.
     return true;
 }
+
+void HexMapTiledNode::mark_navigation_changed(const HexMapCellId &cell_id) {
+    // with navigation_bake_only_navmesh_tiles, the cell below may be
+    // excluded or included based on this cell, so invalidate that octant
+    // too.
+    HexMapCellId below = cell_id + HexMapCellId(0, 0, -1);
+    for (const HexMapCellId &id : { cell_id, below }) {
+        if (!id.in_bounds()) {
+            continue;
+        }
+        Octant **octant = octants.getptr(OctantKey(id, octant_size));
+        if (octant != nullptr) {
+            (*octant)->set_navigation_dirty();
+        }
+    }
+
+    // grow the changed region by the cell and the cell below it
+    Vector3 scale = space.get_cell_scale();
+    Vector3 center = space.get_cell_center(cell_id) +
+            get_mesh_origin_vec() * scale;
+    AABB cell_aabb(center - Vector3(scale.x, scale.y * 1.5, scale.x),
+            Vector3(scale.x * 2, scale.y * 2, scale.x * 2));
+
+    // and by the item in the cell, which may be larger than the cell
+    const Cell *cell = cell_map.getptr(cell_id);
+    if (cell != nullptr && library_cache.is_valid()) {
+        const HexMapLibraryCache::Item *item =
+                library_cache->get_item(cell->value);
+        if (item != nullptr) {
+            Transform3D cell_transform(cell->get_basis(), center);
+            cell_aabb.merge_with(cell_transform.xform(item->aabb));
+        }
+    }
+    if (navigation_changed) {
+        navigation_changed_aabb.merge_with(cell_aabb);
+    } else {
+        navigation_changed_aabb = cell_aabb;
+        navigation_changed = true;
+    }
+}
+
+void HexMapTiledNode::mark_all_navigation_changed() {
+    for (const auto &iter : octants) {
+        iter.value->set_navigation_dirty();
+    }
+    for (const auto &iter : cell_map) {
+        mark_navigation_changed(iter.key);
+    }
+}
+
+AABB HexMapTiledNode::get_navigation_changed_aabb() const {
+    if (!navigation_changed) {
+        return AABB();
+    }
+    return space.get_transform().xform(navigation_changed_aabb);
+}
+
+void HexMapTiledNode::clear_navigation_changed_aabb() {
+    navigation_changed = false;
+    navigation_changed_aabb = AABB();
+}
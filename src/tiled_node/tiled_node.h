@@ -12,12 +12,18 @@
 #include <godot_cpp/core/defs.hpp>
 #include <godot_cpp/templates/hash_map.hpp>
 #include <godot_cpp/templates/hash_set.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/templates/safe_refcount.hpp>
 #include <godot_cpp/templates/vector.hpp>
+#include <godot_cpp/variant/aabb.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
 #include <godot_cpp/variant/transform3d.hpp>
 #include <godot_cpp/variant/vector3i.hpp>
 
 #include "core/cell_id.h"
+#include "core/cell_map.h"
 #include "core/hex_map_node.h"
+#include "core/library_cache.h"
 #include "core/planes.h"
 #include "core/tile_orientation.h"
 #include "octant.h"
@@ -45,6 +51,14 @@ public:
         MESH_ORIGIN_BOTTOM,
     };
 
+    // enum for which multimesh channel per-cell custom data is sent to;
+    // matches HexMapMeshTool::CustomDataFormat
+    enum CustomDataFormat {
+        CUSTOM_DATA_NONE = HexMapMeshTool::CUSTOM_DATA_NONE,
+        CUSTOM_DATA_COLOR = HexMapMeshTool::CUSTOM_DATA_COLOR,
+        CUSTOM_DATA_CUSTOM = HexMapMeshTool::CUSTOM_DATA_CUSTOM,
+    };
+
     /// source geometry parser for all TiledNode instances; this is the
     /// id within the RID, or 0 when not set.
     // We cannot declare this as `static RID` because the godot dll provides
@@ -58,6 +72,13 @@ public:
     // This is released in uninitialize_hexmap_module()
     static uint64_t navigation_source_geometry_parser;
 
+    /// Performance monitor counters, shared by all TiledNode instances
+    static SafeNumeric<int64_t> monitor_cells;
+    /// octants rebuilt, and time taken in microseconds, by the most recent
+    /// update_dirty_octants_callback()
+    static SafeNumeric<int64_t> monitor_dirty_octants;
+    static SafeNumeric<uint64_t> monitor_update_usec;
+
 private:
     /**
      * @brief A Cell is a single cell in the cube map space; it is defined by
@@ -68,6 +89,8 @@ private:
             unsigned int value : 16;
             unsigned int rot : 4;
             unsigned int visible : 1;
+            /// cell is enclosed by occluders and excluded from the meshes
+            unsigned int occluded : 1;
         };
         uint32_t cell = 0;
 
@@ -80,11 +103,14 @@ private:
     };
 
     Ref<MeshLibrary> mesh_library;
+    /// per-item data from `mesh_library`; null if no `mesh_library` is set
+    Ref<HexMapLibraryCache> library_cache;
 
     // map properties
     real_t cell_radius = 1.0;
     real_t cell_height = 1.0;
     MeshOrigin mesh_origin = MeshOrigin::MESH_ORIGIN_CENTER;
+    CustomDataFormat custom_data_format = CUSTOM_DATA_NONE;
 
     // rendering properties
     int octant_size = 8;
@@ -100,17 +126,73 @@ private:
     real_t physics_body_bounce = 0.0;
 
     bool navigation_bake_only_navmesh_tiles = false;
-
-    HashMap<CellKey, Cell> cell_map;
+    bool navigation_use_item_navmesh = false;
+
+    // local space region containing every cell modified since the last
+    // clear_navigation_changed_aabb() call, and the items in those cells
+    // before and after the change.
+    AABB navigation_changed_aabb;
+    bool navigation_changed = false;
+    void mark_navigation_changed(const HexMapCellId &);
+    void mark_all_navigation_changed();
+
+    // distance based level of detail
+    real_t lod_visibility_range_begin = 0;
+    real_t lod_visibility_range_end = 0;
+    bool lod_far_mesh_enabled = false;
+    real_t lod_far_mesh_distance = 100;
+
+    // far LOD meshes being built on the WorkerThreadPool; only one batch is
+    // in flight at a time.
+    struct FarMeshTask {
+        OctantKey octant;
+        uint32_t revision;
+        HexMapOctant::BakeJob job;
+    };
+    LocalVector<FarMeshTask> far_mesh_tasks;
+    HexMapOctant::BakeSurfaceCache far_mesh_surface_cache;
+    int64_t far_mesh_group_id = -1;
+    void far_mesh_task(uint32_t p_index);
+    void queue_far_meshes();
+    void commit_far_meshes();
+    void cancel_far_meshes();
+    void update_octant_visibility_ranges();
+
+    // skip rendering cells that are completely surrounded by occluder cells
+    bool occlusion_culling_enabled = false;
+    HashSet<int> occlusion_culling_occluders;
+
+    HexMapCellMap<Cell> cell_map;
     HashMap<OctantKey, Octant *> octants;
+    /// custom data for cells, only for cells with a value other than white
+    HexMapCellMap<Color> cell_custom_data;
+
+    /// drawn in place of cells whose item has no mesh
+    Ref<ArrayMesh> placeholder_mesh;
+    Ref<ArrayMesh> get_placeholder_mesh();
 
     // The LightmapGI node assumes we're tracking the lightmap meshes by index.
     // We use this Vector to map from the index they have to an OctantKey for
     // lookup in get_bake_mesh_instance().
     Vector<OctantKey> baked_mesh_octants;
 
+    // jobs for bake_octants(); member so bake_octant_task() can reach them
+    // from the WorkerThreadPool.
+    LocalVector<HexMapOctant::BakeJob> bake_jobs;
+    void bake_octant_task(uint32_t p_index);
+    void bake_octants(const Vector<OctantKey> &keys,
+            bool p_gen_lightmap_uv,
+            float p_lightmap_uv_texel_size = 0.1);
+
     void recreate_octant_data();
     void update_octant_meshes();
+    void update_octant_transforms();
+
+    bool is_occluder(const CellKey &) const;
+    bool is_cell_enclosed(const HexMapCellId &) const;
+    void update_cell_occlusion(const HexMapCellId &);
+    void update_occlusion_around(const HexMapCellId &);
+    void update_all_occlusion();
 
     void update_physics_bodies_collision_properties();
     void update_physics_bodies_characteristics();
@@ -130,6 +212,8 @@ protected:
     void _update_visibility();
     static void _bind_methods();
 
+    void snapshot_cells(HexMapCellMap<CellInfo> &cells) const override;
+
 public:
     void set_mesh_library(const Ref<MeshLibrary> &);
     Ref<MeshLibrary> get_mesh_library() const;
@@ -139,7 +223,31 @@ public:
     MeshOrigin get_mesh_origin() const;
     Vector3 get_mesh_origin_vec() const;
 
+    void set_custom_data_format(CustomDataFormat);
+    CustomDataFormat get_custom_data_format() const;
+
+    /// set per-cell custom data sent to the multimesh instance for the cell;
+    /// see `cell_custom_data_format`.  Updating the value only rewrites the
+    /// instance data, the multimeshes are not rebuilt.  Value is not saved.
+    ///
+    /// Custom data only exists on the multimesh instances; baked meshes and
+    /// far LOD meshes merge the item geometry without it, so cells in those
+    /// octants are drawn untinted.
+    void set_cell_custom_data(const HexMapCellId &, const Color &);
+    void _set_cell_custom_data(const Ref<hex_bind::HexMapCellId>,
+            const Color &);
+    Color get_cell_custom_data(const HexMapCellId &) const;
+    Color _get_cell_custom_data(const Ref<hex_bind::HexMapCellId>) const;
+
+    /// set the custom data for multiple cells
+    ///
+    /// `cells` is a flat Array containing two members for each cell:
+    /// - `Vector3i` representing the cell id
+    /// - `Color` custom data value
+    void set_cells_custom_data(const Array cells);
+
     bool on_hex_space_changed() override;
+    void on_hex_space_transform_changed() override;
 
     void set_collision_debug(bool value);
     bool get_collision_debug() const;
@@ -165,9 +273,36 @@ public:
     void set_navigation_bake_only_navmesh_tiles(bool);
     bool get_navigation_bake_only_navmesh_tiles() const;
 
+    /// Use the geometry of each item's `MeshLibrary` navigation mesh as the
+    /// navigation source geometry instead of the item render mesh.  Cells
+    /// without a navigation mesh are skipped.
+    void set_navigation_use_item_navmesh(bool);
+    bool get_navigation_use_item_navmesh() const;
+
     void set_octant_size(int p_size);
     int get_octant_size() const;
 
+    void set_lod_visibility_range_begin(real_t);
+    real_t get_lod_visibility_range_begin() const;
+    void set_lod_visibility_range_end(real_t);
+    real_t get_lod_visibility_range_end() const;
+
+    /// replace each octant with a single merged, decimated mesh when it is
+    /// further than `lod_far_mesh_distance` from the camera.  The distance is
+    /// clamped to `lod_visibility_range_end` when that is set.
+    void set_lod_far_mesh_enabled(bool);
+    bool get_lod_far_mesh_enabled() const;
+    void set_lod_far_mesh_distance(real_t);
+    real_t get_lod_far_mesh_distance() const;
+
+    void set_occlusion_culling_enabled(bool);
+    bool get_occlusion_culling_enabled() const;
+
+    /// set the MeshLibrary item ids that completely fill their cell.  Any
+    /// cell with occluders on all six sides, above & below is not rendered.
+    void set_occlusion_culling_occluders(const PackedInt32Array &);
+    PackedInt32Array get_occlusion_culling_occluders() const;
+
     Transform3D get_cell_transform(const HexMapCellId &) const;
 
     void set_cell(const HexMapCellId &,
@@ -177,6 +312,7 @@ public:
     bool has(HexMapCellId) const override;
     Array get_cell_vecs() const override;
     Array find_cell_vecs_by_value(int value) const override;
+    Dictionary get_memory_usage() const override;
 
     // used by the editor to conceal cells for the editor cursor
     // value is not saved
@@ -189,6 +325,14 @@ public:
     Array get_bake_meshes();
     RID get_bake_mesh_instance(int p_idx);
 
+    /// Get the region, in global space, that contains every cell modified
+    /// since the last call to `clear_navigation_changed_aabb()`, including
+    /// item meshes that extend beyond their cell.  Returns an empty AABB if
+    /// nothing has changed.  Use this to limit navigation mesh rebakes to the
+    /// modified part of the map.
+    AABB get_navigation_changed_aabb() const;
+    void clear_navigation_changed_aabb();
+
     static bool generate_navigation_source_geometry(Ref<NavigationMesh>,
             Ref<NavigationMeshSourceGeometryData3D>,
             Node *);
@@ -203,3 +347,4 @@ public:
 };
 
 VARIANT_ENUM_CAST(HexMapTiledNode::MeshOrigin);
+VARIANT_ENUM_CAST(HexMapTiledNode::CustomDataFormat);
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "core/cell_map.h"
+#include "doctest.h"
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+
+// Compare every element of a HexMapCellMap with a std::unordered_map holding
+// the same cells.
+template <typename V>
+void check_cell_map_equal(const HexMapCellMap<V> &map,
+        const std::unordered_map<uint64_t, V> &expected) {
+    REQUIRE(map.size() == expected.size());
+    CHECK(map.is_empty() == expected.empty());
+
+    uint32_t visited = 0;
+    for (const auto &iter : map) {
+        visited++;
+        auto found = expected.find(iter.key.key);
+        REQUIRE(found != expected.end());
+        CHECK(iter.value == found->second);
+    }
+    CHECK(visited == map.size());
+
+    for (const auto &[key, value] : expected) {
+        const V *ptr = map.getptr(HexMapCellId::Key(key));
+        REQUIRE(ptr != nullptr);
+        CHECK(*ptr == value);
+    }
+}
+
+// Run a random mix of inserts, erases, lookups & clears on a HexMapCellMap
+// and a std::unordered_map, checking that they agree throughout.  The cells
+// come from a small region so erases hit, and tombstones pile up.
+template <typename V>
+void check_cell_map_random_ops(uint32_t seed, int ops) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> coord(-20, 20);
+    std::uniform_int_distribution<int> layer(-3, 3);
+    std::uniform_int_distribution<int> action(0, 999);
+
+    HexMapCellMap<V> map;
+    std::unordered_map<uint64_t, V> expected;
+
+    for (int i = 0; i < ops; i++) {
+        CAPTURE(i);
+        HexMapCellId::Key key(
+                HexMapCellId(coord(rng), coord(rng), layer(rng)));
+        V value{ (uint32_t)i };
+        int roll = action(rng);
+
+        if (roll < 500) {
+            map.insert(key, value);
+            expected[key.key] = value;
+        } else if (roll < 800) {
+            CHECK(map.erase(key) == (expected.erase(key.key) == 1));
+        } else if (roll < 999) {
+            auto found = expected.find(key.key);
+            const V *ptr = map.getptr(key);
+            REQUIRE((ptr != nullptr) == (found != expected.end()));
+            if (ptr != nullptr) {
+                CHECK(*ptr == found->second);
+            }
+        } else {
+            map.clear();
+            expected.clear();
+        }
+
+        if (i % 1000 == 0) {
+            check_cell_map_equal(map, expected);
+        }
+    }
+    check_cell_map_equal(map, expected);
+}
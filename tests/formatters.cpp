@@ -1,6 +1,8 @@
 #include "formatters.h"
 #include "core/iter_axial.h"
 #include "core/iter_radial.h"
+#include "core/iter_ring.h"
+#include "core/iter_spiral.h"
 #include <ostream>
 
 namespace godot {
@@ -65,6 +67,31 @@ std::ostream &operator<<(std::ostream &os, const HexMapIterRadial &value) {
     return os;
 }
 
+std::ostream &operator<<(std::ostream &os, const HexMapIterRing &value) {
+    // clang-format off
+    os << "{ .center = " << value.center
+       << ", .radius = " << value.radius
+       << ", .cell = " << value.cell
+       << ", .side = " << value.side
+       << ", .step = " << value.step
+       << " }";
+    // clang-format on
+
+    return os;
+}
+
+std::ostream &operator<<(std::ostream &os, const HexMapIterSpiral &value) {
+    // clang-format off
+    os << "{ .center = " << value.center
+       << ", .radius = " << value.radius
+       << ", .exclude_center = " << value.exclude_center
+       << ", .ring = " << value.ring
+       << " }";
+    // clang-format on
+
+    return os;
+}
+
 std::ostream &operator<<(std::ostream &os, const HexMapIterAxial &value) {
     // clang-format off
     os << "{ .center = " << value.center
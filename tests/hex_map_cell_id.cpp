@@ -60,3 +60,71 @@ TEST_CASE("HexMapCellId::operator Vector3i() reversability") {
             vector,
             after);
 }
+
+TEST_CASE("HexMapCellId::Key::to_morton()") {
+    using Key = HexMapCellId::Key;
+
+    SUBCASE("round trip") {
+        for (const HexMapCellId &cell_id : {
+                     HexMapCellId(0, 0, 0),
+                     HexMapCellId(1, -2, 3),
+                     HexMapCellId(-32768, 32767, -1),
+                     HexMapCellId(32767, -32768, 0),
+                     HexMapCellId(1234, -4321, 77),
+             }) {
+            CHECK(HexMapCellId(Key::from_morton(Key(cell_id).to_morton())) ==
+                    cell_id);
+        }
+    }
+
+    SUBCASE("bits are interleaved q, r, y") {
+        uint64_t origin = Key(HexMapCellId(0, 0, 0)).to_morton();
+        CHECK((Key(HexMapCellId(1, 0, 0)).to_morton() ^ origin) == 0b001);
+        CHECK((Key(HexMapCellId(0, 1, 0)).to_morton() ^ origin) == 0b010);
+        CHECK((Key(HexMapCellId(0, 0, 1)).to_morton() ^ origin) == 0b100);
+    }
+
+    SUBCASE("negative coordinates sort before positive") {
+        CHECK(Key(HexMapCellId(-1, 0, 0)).to_morton() <
+                Key(HexMapCellId(0, 0, 0)).to_morton());
+        CHECK(Key(HexMapCellId(-5, -5, -5)).to_morton() <
+                Key(HexMapCellId(5, 5, 5)).to_morton());
+    }
+}
+
+TEST_CASE("HexMapCellId::get_line()") {
+    LocalVector<HexMapCellId> line;
+
+    SUBCASE("every step crosses a single face") {
+        const HexMapCellId cells[] = {
+            HexMapCellId(0, 0, 0),
+            HexMapCellId(1, 0, 1),
+            HexMapCellId(5, -2, 3),
+            HexMapCellId(-7, 4, -2),
+            HexMapCellId(3, 3, 0),
+            HexMapCellId(-2, -6, 7),
+            HexMapCellId(0, 0, -4),
+        };
+        for (const HexMapCellId &from : cells) {
+            for (const HexMapCellId &to : cells) {
+                CAPTURE(from);
+                CAPTURE(to);
+                from.get_line(to, line);
+                REQUIRE(line.size() == from.distance(to) + 1);
+                CHECK(line[0] == from);
+                CHECK(line[line.size() - 1] == to);
+                for (uint32_t i = 1; i < line.size(); i++) {
+                    CHECK(line[i - 1].distance(line[i]) == 1);
+                }
+            }
+        }
+    }
+
+    SUBCASE("changing layer beside a wall goes through a neighbor") {
+        // the line passes exactly through the edge shared by (1, 0, 0) and
+        // (0, 0, 1); it must step through one of them, not between them
+        HexMapCellId(0, 0, 0).get_line(HexMapCellId(1, 0, 1), line);
+        REQUIRE(line.size() == 3);
+        CHECK(line[1] == HexMapCellId(1, 0, 0));
+    }
+}
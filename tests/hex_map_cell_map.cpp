@@ -0,0 +1,330 @@
+#include "cell_map_checks.h"
+#include "core/cell_id.h"
+#include "core/cell_map.h"
+#include "doctest.h"
+#include <unordered_map>
+#include <utility>
+
+using CellId = HexMapCellId;
+using Map = HexMapCellMap<uint32_t>;
+
+// cells of a layered 7x7 block; a different cell for every index
+static CellId block_cell(int index) {
+    return CellId(index % 7 - 3, (index / 7) % 7 - 3, index / 49 - 2);
+}
+
+TEST_CASE("HexMapCellMap") {
+    SUBCASE("empty map") {
+        Map map;
+        CHECK(map.is_empty());
+        CHECK(map.size() == 0);
+        CHECK(map.get_capacity() == 0);
+        CHECK(map.get_allocated_size() == 0);
+        CHECK(map.getptr(CellId(1, 2, 3)) == nullptr);
+        CHECK_FALSE(map.has(CellId(1, 2, 3)));
+        CHECK_FALSE(map.erase(CellId(1, 2, 3)));
+        CHECK(map.begin() == map.end());
+    }
+
+    SUBCASE("insert, overwrite and operator[]") {
+        Map map;
+        map.insert(CellId(1, 2, 3), 10);
+        map.insert(CellId(-1, -2, -3), 20);
+        CHECK(map.size() == 2);
+        CHECK(map.get_capacity() == 16);
+        CHECK(map.get_allocated_size() > 0);
+        REQUIRE(map.getptr(CellId(1, 2, 3)) != nullptr);
+        CHECK(*map.getptr(CellId(1, 2, 3)) == 10);
+        CHECK(map[CellId(-1, -2, -3)] == 20);
+        CHECK_FALSE(map.has(CellId(3, 2, 1)));
+
+        // insert() replaces the value of an existing key
+        map.insert(CellId(1, 2, 3), 11);
+        CHECK(map.size() == 2);
+        CHECK(map[CellId(1, 2, 3)] == 11);
+
+        // operator[] inserts a default value for a missing key
+        CHECK(map[CellId(5, 5, 5)] == 0);
+        CHECK(map.size() == 3);
+        map[CellId(5, 5, 5)] = 50;
+        CHECK(*map.getptr(CellId(5, 5, 5)) == 50);
+
+        const Map &const_map = map;
+        CHECK(const_map[CellId(5, 5, 5)] == 50);
+        CHECK(const_map.getptr(CellId(6, 6, 6)) == nullptr);
+    }
+
+    SUBCASE("erase then reinsert reuses the slot") {
+        Map map;
+        for (int i = 0; i < 10; i++) {
+            map.insert(block_cell(i), i);
+        }
+        REQUIRE(map.get_capacity() == 16);
+
+        // With room to spare, each reinsert fills the tombstone the erase
+        // left behind, and the table never grows.
+        for (int round = 0; round < 1000; round++) {
+            CellId cell = block_cell(round % 10);
+            REQUIRE(map.erase(cell));
+            CHECK_FALSE(map.has(cell));
+            CHECK_FALSE(map.erase(cell));
+            CHECK(map.size() == 9);
+            map.insert(cell, round);
+            CHECK(map[cell] == (uint32_t)round);
+        }
+        CHECK(map.size() == 10);
+        CHECK(map.get_capacity() == 16);
+        for (int i = 0; i < 10; i++) {
+            CHECK(map.has(block_cell(i)));
+        }
+    }
+
+    SUBCASE("tombstones are reclaimed without growing") {
+        // Churn many distinct cells through a map that never holds more
+        // than a few at once.  Each erase leaves a tombstone, so the table
+        // runs out of empty slots repeatedly; with most of the used slots
+        // being tombstones, it must rehash at the same capacity.
+        Map map;
+        for (int i = 0; i < 300; i++) {
+            map.insert(block_cell(i), i);
+            if (i >= 4) {
+                REQUIRE(map.erase(block_cell(i - 4)));
+            }
+            CHECK(map.get_capacity() == 16);
+        }
+        CHECK(map.size() == 4);
+        for (int i = 296; i < 300; i++) {
+            CHECK(map[block_cell(i)] == (uint32_t)i);
+        }
+        CHECK_FALSE(map.has(block_cell(0)));
+    }
+
+    SUBCASE("growth doubles the capacity") {
+        // 7/8 of 16 slots may be filled before the table grows
+        Map map;
+        for (int i = 0; i < 14; i++) {
+            map.insert(block_cell(i), i);
+        }
+        CHECK(map.get_capacity() == 16);
+        map.insert(block_cell(14), 14);
+        CHECK(map.get_capacity() == 32);
+
+        for (int i = 15; i < 200; i++) {
+            map.insert(block_cell(i), i);
+        }
+        CHECK(map.get_capacity() == 256);
+        CHECK(map.size() == 200);
+        for (int i = 0; i < 200; i++) {
+            REQUIRE(map.getptr(block_cell(i)) != nullptr);
+            CHECK(*map.getptr(block_cell(i)) == (uint32_t)i);
+        }
+    }
+
+    SUBCASE("clear keeps the table") {
+        Map map;
+        for (int i = 0; i < 100; i++) {
+            map.insert(block_cell(i), i);
+        }
+        uint32_t capacity = map.get_capacity();
+        map.clear();
+        CHECK(map.is_empty());
+        CHECK(map.get_capacity() == capacity);
+        CHECK(map.begin() == map.end());
+        CHECK_FALSE(map.has(block_cell(0)));
+
+        map.insert(block_cell(0), 7);
+        CHECK(map.size() == 1);
+        CHECK(map[block_cell(0)] == 7);
+
+        // clearing an empty map is harmless
+        Map empty;
+        empty.clear();
+        CHECK(empty.get_capacity() == 0);
+    }
+
+    SUBCASE("reserve") {
+        Map map;
+        map.reserve(100);
+        uint32_t capacity = map.get_capacity();
+        CHECK(capacity == 128);
+        for (int i = 0; i < 100; i++) {
+            map.insert(block_cell(i), i);
+        }
+        CHECK(map.get_capacity() == capacity);
+
+        // reserving less than is already available does nothing
+        map.reserve(10);
+        CHECK(map.get_capacity() == capacity);
+
+        // reserving more keeps the existing elements
+        map.reserve(1000);
+        CHECK(map.get_capacity() == 2048);
+        CHECK(map.size() == 100);
+        for (int i = 0; i < 100; i++) {
+            CHECK(map[block_cell(i)] == (uint32_t)i);
+        }
+    }
+
+    SUBCASE("iteration visits every element once") {
+        Map map;
+        std::unordered_map<uint64_t, uint32_t> expected;
+        for (int i = 0; i < 150; i++) {
+            map.insert(block_cell(i), i);
+            expected[Map::Key(block_cell(i)).key] = i;
+        }
+        for (int i = 0; i < 150; i += 3) {
+            map.erase(block_cell(i));
+            expected.erase(Map::Key(block_cell(i)).key);
+        }
+        check_cell_map_equal(map, expected);
+
+        // values can be changed through the iterator
+        for (auto &iter : map) {
+            iter.value += 1000;
+        }
+        for (auto &[key, value] : expected) {
+            value += 1000;
+        }
+        check_cell_map_equal(map, expected);
+    }
+
+    SUBCASE("copy") {
+        Map map;
+        for (int i = 0; i < 40; i++) {
+            map.insert(block_cell(i), i);
+        }
+        map.erase(block_cell(3));
+
+        Map copy(map);
+        CHECK(copy.size() == map.size());
+        CHECK(copy.get_capacity() == map.get_capacity());
+        for (const auto &iter : map) {
+            CHECK(copy[iter.key] == iter.value);
+        }
+        CHECK_FALSE(copy.has(block_cell(3)));
+
+        // the copy does not share storage
+        copy.insert(block_cell(0), 100);
+        copy.erase(block_cell(1));
+        CHECK(map[block_cell(0)] == 0);
+        CHECK(map.has(block_cell(1)));
+
+        // assignment replaces the existing contents
+        Map other;
+        other.insert(CellId(100, 100, 100), 1);
+        other = map;
+        CHECK(other.size() == map.size());
+        CHECK_FALSE(other.has(CellId(100, 100, 100)));
+        CHECK(other[block_cell(1)] == 1);
+
+        // and copying an empty map leaves nothing behind
+        Map empty;
+        other = empty;
+        CHECK(other.is_empty());
+        CHECK(other.get_capacity() == 0);
+        Map empty_copy(other);
+        CHECK(empty_copy.is_empty());
+    }
+
+    SUBCASE("move") {
+        Map map;
+        for (int i = 0; i < 40; i++) {
+            map.insert(block_cell(i), i);
+        }
+        uint32_t capacity = map.get_capacity();
+
+        Map moved(std::move(map));
+        CHECK(moved.size() == 40);
+        CHECK(moved.get_capacity() == capacity);
+        CHECK(moved[block_cell(39)] == 39);
+        CHECK(map.is_empty());
+        CHECK(map.get_capacity() == 0);
+
+        // the moved-from map is usable
+        map.insert(block_cell(0), 5);
+        CHECK(map[block_cell(0)] == 5);
+
+        map = std::move(moved);
+        CHECK(map.size() == 40);
+        CHECK(map[block_cell(0)] == 0);
+        CHECK(moved.is_empty());
+        CHECK(moved.getptr(block_cell(0)) == nullptr);
+    }
+
+    SUBCASE("missing keys are not found after wrapping around") {
+        // In a nearly full 16 slot table, the group loaded at any slot but
+        // the first wraps past the end, and lookups of missing keys must
+        // stop at an empty slot without running past the table.
+        Map map;
+        for (int i = 0; i < 14; i++) {
+            map.insert(block_cell(i), i);
+        }
+        REQUIRE(map.get_capacity() == 16);
+        for (int q = -30; q <= 30; q++) {
+            for (int r = -30; r <= 30; r++) {
+                CellId cell(q, r, 10);
+                CHECK_FALSE(map.has(cell));
+            }
+        }
+
+        // same again with tombstones in the probe sequences
+        for (int i = 0; i < 14; i += 2) {
+            map.erase(block_cell(i));
+        }
+        for (int q = -30; q <= 30; q++) {
+            for (int r = -30; r <= 30; r++) {
+                CHECK_FALSE(map.has(CellId(q, r, 10)));
+            }
+        }
+        for (int i = 1; i < 14; i += 2) {
+            CHECK(map[block_cell(i)] == (uint32_t)i);
+        }
+    }
+
+    SUBCASE("negative and extreme coordinates are distinct keys") {
+        Map map;
+        const CellId cells[] = {
+            CellId(0, 0, 0),
+            CellId(-1, 0, 0),
+            CellId(0, -1, 0),
+            CellId(0, 0, -1),
+            CellId(INT16_MAX, INT16_MIN, 0),
+            CellId(INT16_MIN, INT16_MAX, 0),
+            CellId(0, 0, INT16_MIN),
+        };
+        uint32_t value = 0;
+        for (const CellId &cell : cells) {
+            map.insert(cell, value++);
+        }
+        CHECK(map.size() == 7);
+        value = 0;
+        for (const CellId &cell : cells) {
+            CHECK(map[cell] == value++);
+        }
+    }
+}
+
+TEST_CASE("HexMapCellMap matches std::unordered_map") {
+    for (uint32_t seed : { 1, 2, 3 }) {
+        CAPTURE(seed);
+        check_cell_map_random_ops<uint32_t>(seed, 20000);
+    }
+}
+
+TEST_CASE("HexMapCellSet") {
+    HexMapCellSet set;
+    set.insert(CellId(1, 2, 3), {});
+    set.insert(CellId(1, 2, 3), {});
+    set.insert(CellId(3, 2, 1), {});
+    CHECK(set.size() == 2);
+    CHECK(set.has(CellId(1, 2, 3)));
+    CHECK_FALSE(set.has(CellId(2, 2, 2)));
+
+    int visited = 0;
+    for (const auto &iter : set) {
+        CellId cell = iter.key;
+        CHECK((cell == CellId(1, 2, 3) || cell == CellId(3, 2, 1)));
+        visited++;
+    }
+    CHECK(visited == 2);
+}
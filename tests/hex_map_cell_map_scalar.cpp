@@ -0,0 +1,45 @@
+// Build HexMapCellMap with the portable group matching in this file, so the
+// fallback for targets without SSE2 is tested on every machine.
+#define HEX_MAP_CELL_MAP_NO_SSE2
+#include "core/cell_map.h"
+
+#ifdef HEX_MAP_CELL_MAP_SSE2
+#error "cell_map.h was included before HEX_MAP_CELL_MAP_NO_SSE2 was defined"
+#endif
+
+#include "cell_map_checks.h"
+#include "doctest.h"
+
+// The map template is compiled differently here than in the other tests.
+// Instantiate it only with a value type local to this file, so none of these
+// functions can be merged with the SSE2 ones at link time.
+namespace {
+struct ScalarValue {
+    uint32_t value;
+    bool operator==(const ScalarValue &other) const {
+        return value == other.value;
+    }
+};
+} //namespace
+
+TEST_CASE("HexMapCellMap without SSE2 matches std::unordered_map") {
+    for (uint32_t seed : { 4, 5, 6 }) {
+        CAPTURE(seed);
+        check_cell_map_random_ops<ScalarValue>(seed, 20000);
+    }
+}
+
+TEST_CASE("HexMapCellMap without SSE2 reclaims tombstones") {
+    HexMapCellMap<ScalarValue> map;
+    for (int i = 0; i < 300; i++) {
+        map.insert(HexMapCellId(i, -i, 0), { (uint32_t)i });
+        if (i >= 4) {
+            REQUIRE(map.erase(HexMapCellId(i - 4, 4 - i, 0)));
+        }
+    }
+    CHECK(map.size() == 4);
+    CHECK(map.get_capacity() == 16);
+    for (int q = -30; q <= 30; q++) {
+        CHECK_FALSE(map.has(HexMapCellId(q, q, 1)));
+    }
+}
@@ -0,0 +1,47 @@
+#include "core/cell_id.h"
+#include "core/iter_ring.h"
+#include "doctest.h"
+#include "formatters.h"
+#include <set>
+#include <vector>
+
+using CellId = HexMapCellId;
+
+TEST_CASE("HexMapIterRing") {
+    SUBCASE("radius 0 is the center") {
+        std::vector<CellId> cells;
+        for (const CellId &cell : HexMapIterRing(CellId(1, 2, 3), 0)) {
+            cells.push_back(cell);
+        }
+        CHECK(cells == std::vector<CellId>{ CellId(1, 2, 3) });
+    }
+
+    SUBCASE("radius 1 is the six neighbors") {
+        std::vector<CellId> cells;
+        for (const CellId &cell : HexMapIterRing(CellId(), 1)) {
+            cells.push_back(cell);
+        }
+        std::vector<CellId> expect = {
+            CellId(-1, 1, 0),
+            CellId(0, 1, 0),
+            CellId(1, 0, 0),
+            CellId(1, -1, 0),
+            CellId(0, -1, 0),
+            CellId(-1, 0, 0),
+        };
+        CHECK(cells == expect);
+    }
+
+    SUBCASE("every cell is exactly radius away") {
+        CellId center(3, -7, 2);
+        for (unsigned radius = 1; radius < 10; radius++) {
+            CAPTURE(radius);
+            std::set<CellId> cells;
+            for (const CellId &cell : HexMapIterRing(center, radius)) {
+                CHECK(center.distance(cell) == radius);
+                cells.insert(cell);
+            }
+            CHECK(cells.size() == radius * 6);
+        }
+    }
+}
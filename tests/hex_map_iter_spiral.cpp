@@ -0,0 +1,55 @@
+#include "core/cell_id.h"
+#include "core/iter_radial.h"
+#include "core/iter_spiral.h"
+#include "doctest.h"
+#include "formatters.h"
+#include <set>
+#include <vector>
+
+using CellId = HexMapCellId;
+
+TEST_CASE("HexMapIterSpiral") {
+    SUBCASE("exclude center with radius 0 is empty") {
+        HexMapIterSpiral iter(CellId(), 0, true);
+        CHECK(iter.begin() == iter.end());
+    }
+
+    SUBCASE("cells are ordered by distance") {
+        CellId center(-2, 5, -1);
+        std::vector<CellId> cells;
+        for (const CellId &cell : HexMapIterSpiral(center, 4)) {
+            cells.push_back(cell);
+        }
+        REQUIRE(cells.size() == 61);
+        CHECK(cells[0] == center);
+        for (size_t i = 1; i < cells.size(); i++) {
+            CHECK(center.distance(cells[i - 1]) <= center.distance(cells[i]));
+        }
+    }
+
+    SUBCASE("matches the planar axial iterator") {
+        CellId center(4, -1, 7);
+        for (unsigned radius = 0; radius < 8; radius++) {
+            for (bool exclude_center : { false, true }) {
+                CAPTURE(radius);
+                CAPTURE(exclude_center);
+
+                std::set<CellId> expect;
+                HexMapIterAxial axial(center, radius, HexMapPlanes::QRS);
+                for (const CellId &cell : axial) {
+                    if (center.distance(cell) <= radius &&
+                            !(exclude_center && cell == center)) {
+                        expect.insert(cell);
+                    }
+                }
+
+                std::set<CellId> cells;
+                for (const CellId &cell :
+                        HexMapIterSpiral(center, radius, exclude_center)) {
+                    cells.insert(cell);
+                }
+                CHECK(cells == expect);
+            }
+        }
+    }
+}
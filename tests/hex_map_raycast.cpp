@@ -0,0 +1,67 @@
+#include "core/cell_id.h"
+#include "core/math.h"
+#include "core/raycast.h"
+#include "doctest.h"
+#include "formatters.h"
+
+using CellId = HexMapCellId;
+
+static std::vector<CellId> walk(Vector3 from, Vector3 to) {
+    std::vector<CellId> cells;
+    HexMapRaycast ray(from, to);
+    do {
+        cells.push_back(ray.cell);
+    } while (ray.next());
+    return cells;
+}
+
+TEST_CASE("HexMapRaycast") {
+    SUBCASE("single cell") {
+        CHECK(walk(Vector3(0, 0, 0), Vector3(0.1, 0.1, 0.1)) ==
+                std::vector<CellId>{ CellId(0, 0, 0) });
+    }
+
+    SUBCASE("along q axis") {
+        Vector3 to = CellId(3, 0, 0).unit_center();
+        std::vector<CellId> expect = {
+            CellId(0, 0, 0),
+            CellId(1, 0, 0),
+            CellId(2, 0, 0),
+            CellId(3, 0, 0),
+        };
+        CHECK(walk(Vector3(), to) == expect);
+
+        HexMapRaycast ray(Vector3(), to);
+        CHECK(ray.entry_normal == Vector3());
+        REQUIRE(ray.next());
+        CHECK(ray.cell == CellId(1, 0, 0));
+        CHECK(ray.entry_t == doctest::Approx(1.0 / 6));
+        CHECK(ray.entry_normal == Vector3(-1, 0, 0));
+    }
+
+    SUBCASE("vertical") {
+        std::vector<CellId> expect = {
+            CellId(0, 0, 0),
+            CellId(0, 0, 1),
+            CellId(0, 0, 2),
+        };
+        CHECK(walk(Vector3(), Vector3(0, 2, 0)) == expect);
+
+        HexMapRaycast ray(Vector3(), Vector3(0, -1, 0));
+        REQUIRE(ray.next());
+        CHECK(ray.cell == CellId(0, 0, -1));
+        CHECK(ray.entry_normal == Vector3(0, 1, 0));
+        CHECK_FALSE(ray.next());
+    }
+
+    SUBCASE("every step crosses a single face") {
+        Vector3 from(-3.2, -1.7, 4.1);
+        Vector3 to(7.9, 2.3, -5.6);
+        std::vector<CellId> cells = walk(from, to);
+        CHECK(cells.front() == CellId::from_unit_point(from));
+        CHECK(cells.back() == CellId::from_unit_point(to));
+        for (size_t i = 1; i < cells.size(); i++) {
+            CHECK(cells[i - 1].distance(cells[i]) == 1);
+        }
+    }
+}
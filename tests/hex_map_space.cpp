@@ -0,0 +1,294 @@
+#include "core/cell_id.h"
+#include "core/math.h"
+#include "core/space.h"
+#include "doctest.h"
+#include "formatters.h"
+#include <godot_cpp/templates/vector.hpp>
+#include <godot_cpp/variant/plane.hpp>
+#include <godot_cpp/variant/vector2.hpp>
+#include <set>
+#include <vector>
+
+TEST_CASE("HexMapSpace::get_cell_ids()") {
+    HexMapSpace space;
+    space.set_cell_scale(Vector3(1.5, 0.75, 2.0));
+
+    // odd count so both the four-wide loop and the tail are used
+    const HexMapCellId cells[] = {
+        HexMapCellId(0, 0, 0),
+        HexMapCellId(1, -2, 3),
+        HexMapCellId(-7, 4, -1),
+        HexMapCellId(12, 0, 5),
+        HexMapCellId(-3, -3, 0),
+        HexMapCellId(100, -50, -20),
+        HexMapCellId(-1, 1, 2),
+    };
+    const size_t count = sizeof(cells) / sizeof(cells[0]);
+
+    // points offset from the center of each cell, but well inside it
+    Vector3 points[count];
+    for (size_t i = 0; i < count; i++) {
+        points[i] = space.get_cell_center(cells[i]) +
+                Vector3(0.3, -0.2, 0.25) * (i % 3 - 1.0);
+    }
+
+    HexMapCellId::Key keys[count];
+    space.get_cell_ids(points, count, keys);
+    for (size_t i = 0; i < count; i++) {
+        CAPTURE(i);
+        CHECK(HexMapCellId(keys[i]) == cells[i]);
+        CHECK(HexMapCellId(keys[i]) == space.get_cell_id(points[i]));
+    }
+
+    Vector3 centers[count];
+    space.get_cell_centers(keys, count, centers);
+    for (size_t i = 0; i < count; i++) {
+        CAPTURE(i);
+        CHECK(centers[i] == space.get_cell_center(cells[i]));
+    }
+}
+
+TEST_CASE("HexMapSpace::get_cell_ids() rounds like from_unit_point()") {
+    HexMapSpace space;
+    space.set_cell_scale(Vector3(1.5, 0.75, 2.0));
+
+    // Points on the corners and edges of cells, and halfway between layers,
+    // where the rounding is a tie or within a float of one.  The batch
+    // rounds them four at a time with SSE2 where available, and must pick
+    // the same cell as the scalar conversion.
+    const Vector3 offsets[] = {
+        Vector3(0, 0, 1),
+        Vector3(0, 0, -1),
+        Vector3(Math_SQRT3_2, 0, 0.5),
+        Vector3(Math_SQRT3_2, 0, -0.5),
+        Vector3(-Math_SQRT3_2, 0, 0.5),
+        Vector3(-Math_SQRT3_2, 0, -0.5),
+        Vector3(Math_SQRT3_2, 0, 0),
+        Vector3(-Math_SQRT3_2, 0, 0),
+        Vector3(Math_SQRT3_2 / 2, 0, 0.75),
+        Vector3(-Math_SQRT3_2 / 2, 0, -0.75),
+        Vector3(0, 0.5, 0),
+        Vector3(0, -0.5, 0),
+    };
+    const HexMapCellId cells[] = {
+        HexMapCellId(0, 0, 0),
+        HexMapCellId(1, -2, 3),
+        HexMapCellId(-7, 4, -1),
+        HexMapCellId(-3, -3, 0),
+        HexMapCellId(100, -50, -20),
+        HexMapCellId(-1000, 2000, 7),
+    };
+
+    std::vector<Vector3> points;
+    for (const HexMapCellId &cell : cells) {
+        for (const Vector3 &offset : offsets) {
+            points.push_back(
+                    (cell.unit_center() + offset) * space.get_cell_scale());
+        }
+    }
+    REQUIRE(points.size() % 4 == 0);
+
+    std::vector<HexMapCellId::Key> keys(points.size());
+    space.get_cell_ids(points.data(), points.size(), keys.data());
+    for (size_t i = 0; i < points.size(); i++) {
+        CAPTURE(points[i]);
+        CHECK(HexMapCellId(keys[i]) ==
+                HexMapCellId::from_unit_point(
+                        points[i] / space.get_cell_scale()));
+    }
+}
+
+TEST_CASE("HexMapSpace::get_cell_ids() beyond the range of a key") {
+    HexMapSpace space;
+    space.set_cell_scale(Vector3(1.5, 0.75, 2.0));
+
+    const HexMapCellId cells[] = {
+        HexMapCellId(40000, 0, 0),
+        HexMapCellId(0, -40000, 0),
+        HexMapCellId(0, 0, 40000),
+        HexMapCellId(-100000, 50000, -3),
+        HexMapCellId(SHRT_MAX, SHRT_MIN, 0),
+    };
+    const size_t count = sizeof(cells) / sizeof(cells[0]);
+    Vector3 points[count];
+    for (size_t i = 0; i < count; i++) {
+        points[i] = space.get_cell_center(cells[i]);
+    }
+
+    HexMapCellId out[count];
+    space.get_cell_ids(points, count, out);
+    for (size_t i = 0; i < count; i++) {
+        CAPTURE(i);
+        CHECK(out[i] == cells[i]);
+    }
+}
+
+// Same test as the static helper in space.cpp
+static bool point_in_triangle(const Vector2 &s,
+        const Vector2 &a,
+        const Vector2 &b,
+        const Vector2 &c) {
+    Vector2 an = a - s;
+    Vector2 bn = b - s;
+    Vector2 cn = c - s;
+    bool orientation = an.cross(bn) > 0;
+    if ((bn.cross(cn) > 0) != orientation) {
+        return false;
+    }
+    return (cn.cross(an) > 0) == orientation;
+}
+
+// Brute force version of HexMapSpace::get_cell_ids_in_local_quad(); runs the
+// per-cell test on every cell in a box well past the quad bounds, instead of
+// only the cells in the rows the quad covers.  The quad is in unit space.
+static std::set<HexMapCellId> brute_force_quad_cells(Vector3 a,
+        Vector3 b,
+        Vector3 c,
+        Vector3 d,
+        real_t padding) {
+    Plane plane(a, b, c);
+    int axis[2];
+    switch (plane.normal.abs().max_axis_index()) {
+    case Vector3::AXIS_X:
+        axis[0] = Vector3::AXIS_Y;
+        axis[1] = Vector3::AXIS_Z;
+        break;
+    case Vector3::AXIS_Y:
+        axis[0] = Vector3::AXIS_X;
+        axis[1] = Vector3::AXIS_Z;
+        break;
+    default:
+        axis[0] = Vector3::AXIS_X;
+        axis[1] = Vector3::AXIS_Y;
+        break;
+    }
+    Vector2 aa(a[axis[0]], a[axis[1]]);
+    Vector2 ab(b[axis[0]], b[axis[1]]);
+    Vector2 ac(c[axis[0]], c[axis[1]]);
+    Vector2 ad(d[axis[0]], d[axis[1]]);
+
+    real_t scale = 1.0 - padding;
+    const Vector2 corners[6] = {
+        Vector2(0.0, -1.0),
+        Vector2(-Math_SQRT3_2, -0.5),
+        Vector2(-Math_SQRT3_2, 0.5),
+        Vector2(0.0, 1.0),
+        Vector2(Math_SQRT3_2, 0.5),
+        Vector2(Math_SQRT3_2, -0.5),
+    };
+    Vector3 verts[12];
+    for (int i = 0; i < 6; i++) {
+        verts[i] = Vector3(corners[i].x, 0.5, corners[i].y) * scale;
+        verts[i + 6] = Vector3(corners[i].x, -0.5, corners[i].y) * scale;
+    }
+
+    // five cells of margin is past the reach of a tilted plane
+    const int margin = 5;
+    Vector3 min = a.min(b).min(c).min(d);
+    Vector3 max = a.max(b).max(c).max(d);
+    std::set<HexMapCellId> out;
+    for (int y = Math::floor(min.y) - margin; y <= Math::ceil(max.y) + margin;
+            y++) {
+        for (int r = Math::floor(min.z / 1.5) - margin;
+                r <= Math::ceil(max.z / 1.5) + margin;
+                r++) {
+            for (int q = Math::floor(min.x / Math_SQRT3 - r * 0.5) - margin;
+                    q <= Math::ceil(max.x / Math_SQRT3 - r * 0.5) + margin;
+                    q++) {
+                HexMapCellId cell_id(q, r, y);
+                Vector3 center = cell_id.unit_center();
+                Vector2 point(center[axis[0]], center[axis[1]]);
+                bool intersect_quad = point_in_triangle(point, aa, ab, ac) ||
+                        point_in_triangle(point, aa, ad, ac);
+                bool intersect_plane = false;
+                bool above = plane.is_point_over(center);
+                for (const Vector3 &offset : verts) {
+                    Vector3 vert = center + offset;
+                    if (plane.is_point_over(vert) != above) {
+                        intersect_plane = true;
+                    }
+                    Vector2 point(vert[axis[0]], vert[axis[1]]);
+                    if (point_in_triangle(point, aa, ab, ac) ||
+                            point_in_triangle(point, aa, ad, ac)) {
+                        intersect_quad = true;
+                    }
+                }
+                if (intersect_plane && intersect_quad) {
+                    out.insert(cell_id);
+                }
+            }
+        }
+    }
+    return out;
+}
+
+TEST_CASE("HexMapSpace::get_cell_ids_in_local_quad()") {
+    struct Quad {
+        const char *name;
+        Vector3 a, b, c, d;
+    };
+    const Quad quads[] = {
+        { "floor",
+                Vector3(-3.2, 0.2, -2.7),
+                Vector3(4.1, 0.2, -2.7),
+                Vector3(4.1, 0.2, 5.3),
+                Vector3(-3.2, 0.2, 5.3) },
+        { "wall facing z",
+                Vector3(-3.4, -2.1, 1.3),
+                Vector3(4.2, -2.1, 1.3),
+                Vector3(4.2, 3.6, 1.3),
+                Vector3(-3.4, 3.6, 1.3) },
+        { "wall facing x",
+                Vector3(0.7, -2.3, -3.1),
+                Vector3(0.7, -2.3, 4.4),
+                Vector3(0.7, 2.8, 4.4),
+                Vector3(0.7, 2.8, -3.1) },
+        { "tilted toward y",
+                Vector3(-2.5, -1.2, -2.2),
+                Vector3(3.1, -1.2, -2.2),
+                Vector3(3.1, 1.9, 3.4),
+                Vector3(-2.5, 1.9, 3.4) },
+        { "tilted toward z",
+                Vector3(-2.6, -2.2, 0.1),
+                Vector3(3.3, -2.2, 1.4),
+                Vector3(3.3, 3.1, 1.4),
+                Vector3(-2.6, 3.1, 0.1) },
+        { "tilted on every axis",
+                Vector3(-2.0, -1.0, -1.5),
+                Vector3(2.5, 0.5, -1.0),
+                Vector3(3.0, 2.0, 2.5),
+                Vector3(-1.5, 0.5, 2.0) },
+    };
+    const real_t paddings[] = { 0.5, 0.3, 0.1 };
+    const Vector3 scales[] = { Vector3(1, 1, 1), Vector3(1.5, 0.75, 2.0) };
+
+    for (const Quad &quad : quads) {
+        for (real_t padding : paddings) {
+            for (const Vector3 &scale : scales) {
+                CAPTURE(quad.name);
+                CAPTURE(padding);
+                CAPTURE(scale);
+
+                HexMapSpace space;
+                space.set_cell_scale(scale);
+                Vector<HexMapCellId> cells = space.get_cell_ids_in_local_quad(
+                        quad.a * scale,
+                        quad.b * scale,
+                        quad.c * scale,
+                        quad.d * scale,
+                        padding);
+                std::set<HexMapCellId> found;
+                for (const HexMapCellId &cell : cells) {
+                    found.insert(cell);
+                }
+                // no cell is returned twice
+                CHECK(found.size() == (size_t)cells.size());
+
+                std::set<HexMapCellId> expect = brute_force_quad_cells(
+                        quad.a, quad.b, quad.c, quad.d, padding);
+                CHECK(!expect.empty());
+                CHECK(found == expect);
+            }
+        }
+    }
+}
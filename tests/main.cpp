@@ -1,3 +1,19 @@
-#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_IMPLEMENT
+
+#include <cstdlib>
+#include <godot_cpp/godot.hpp>
 
 #include "doctest.h"
+
+int main(int argc, char **argv) {
+    // The tests run without the engine, so there is no GDExtension interface
+    // for godot-cpp to allocate through.  Point it at the C allocator so code
+    // that returns a Vector can be tested.
+    godot::internal::gdextension_interface_mem_alloc = std::malloc;
+    godot::internal::gdextension_interface_mem_realloc = std::realloc;
+    godot::internal::gdextension_interface_mem_free = std::free;
+
+    doctest::Context context;
+    context.applyCommandLine(argc, argv);
+    return context.run();
+}